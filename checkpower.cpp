@@ -13,6 +13,11 @@
 #include <io.h>
 #include <gdiplus.h>
 #include <algorithm> // Добавляем этот заголовочный файл
+#include <chrono>
+#include "ie_parser.h"
+#include "rssi_store.h"
+#include "scan_filter.h"
+#include "wifi_core.h"
 
 #pragma comment(lib, "comctl32.lib")
 #pragma comment(lib, "wlanapi.lib")
@@ -22,11 +27,19 @@
 using namespace Gdiplus;
 
 const double FREQUENCY = 2.4; // Frequency in GHz
+const wchar_t HISTORY_DIR_NAME[] = L"rssi-history";
+const UINT HISTORY_FLUSH_INTERVAL_MS = 5 * 60 * 1000;
+const int64_t GRAPH_HISTORY_WINDOW_MS = 60 * 60 * 1000; // История для графика за последний час
+const int ID_FILTER_EDIT = 101;
+const wchar_t WINDOW_TITLE[] = L"Wi-Fi Signal Strength Monitor";
 
 struct Network {
     std::wstring SSID;
     std::wstring BSSID;
+    uint64_t BSSIDKey; // BSSID packed into 48 bits, key for the history store
     int Signal; // Signal strength in dBm
+    int Frequency; // Channel center frequency in MHz
+    BssCapabilities Capabilities; // Decoded from the beacon information elements
     std::vector<int> SignalHistory; // История сигналов для графика
 };
 
@@ -36,6 +49,9 @@ struct GraphData {
 };
 
 std::wstring convert_ssid(const BYTE* ssid, DWORD length) {
+    if (is_hidden_ssid(ssid, length)) {
+        return L""; // Скрытая сеть
+    }
     bool is_ascii = true;
     for (DWORD i = 0; i < length; ++i) {
         if (ssid[i] < 0x20 || ssid[i] > 0x7E) {
@@ -58,74 +74,41 @@ std::wstring convert_ssid(const BYTE* ssid, DWORD length) {
 }
 
 std::vector<Network> get_wifi_networks() {
+    static BssCapabilityCache capabilityCache; // IE разбираются заново только при изменении beacon
     std::vector<Network> networks;
-    HANDLE hClient = NULL;
-    DWORD dwMaxClient = 2;
-    DWORD dwCurVersion = 0;
-
-    if (WlanOpenHandle(dwMaxClient, NULL, &dwCurVersion, &hClient) != ERROR_SUCCESS) {
-        std::wcerr << L"Failed to open WLAN handle." << std::endl;
-        return networks;
-    }
-
-    PWLAN_INTERFACE_INFO_LIST pIfList = NULL;
-    if (WlanEnumInterfaces(hClient, NULL, &pIfList) != ERROR_SUCCESS) {
-        std::wcerr << L"Failed to enumerate WLAN interfaces." << std::endl;
-        WlanCloseHandle(hClient, NULL);
-        return networks;
-    }
-
-    if (pIfList != NULL) {
-        for (int i = 0; i < (int)pIfList->dwNumberOfItems; i++) {
-            PWLAN_INTERFACE_INFO pIfInfo = &pIfList->InterfaceInfo[i];
-
-            // Выполняем сканирование перед получением списка сетей
-            if (WlanScan(hClient, &pIfInfo->InterfaceGuid, NULL, NULL, NULL) != ERROR_SUCCESS) {
-                std::wcerr << L"Failed to scan networks for interface " << i << std::endl;
-                continue;
-            }
-
-            PWLAN_BSS_LIST pBssList = NULL;
-            if (WlanGetNetworkBssList(hClient, &pIfInfo->InterfaceGuid, NULL, dot11_BSS_type_any, FALSE, NULL, &pBssList) == ERROR_SUCCESS) {
-                if (pBssList != NULL) {
-                    for (unsigned int j = 0; j < pBssList->dwNumberOfItems; j++) {
-                        PWLAN_BSS_ENTRY pBssEntry = &pBssList->wlanBssEntries[j];
-
-                        Network network;
-                        network.SSID = convert_ssid(pBssEntry->dot11Ssid.ucSSID, pBssEntry->dot11Ssid.uSSIDLength);
-                        network.BSSID = L"";
-                        for (int k = 0; k < 6; k++) {
-                            wchar_t buffer[3];
-                            swprintf(buffer, 3, L"%02X", pBssEntry->dot11Bssid[k]);
-                            network.BSSID += buffer;
-                            if (k < 5) network.BSSID += L":";
-                        }
-                        network.Signal = pBssEntry->lRssi;
-                        networks.push_back(network);
-                    }
-                    WlanFreeMemory(pBssList);
-                }
-            } else {
-                std::wcerr << L"Failed to get BSS list for interface " << i << std::endl;
-            }
+    for_each_bss_entry([&networks](const WLAN_BSS_ENTRY& entry) {
+        Network network;
+        network.SSID = convert_ssid(entry.dot11Ssid.ucSSID, entry.dot11Ssid.uSSIDLength);
+        network.BSSID = L"";
+        network.BSSIDKey = 0;
+        for (int k = 0; k < 6; k++) {
+            wchar_t buffer[3];
+            swprintf(buffer, 3, L"%02X", entry.dot11Bssid[k]);
+            network.BSSID += buffer;
+            if (k < 5) network.BSSID += L":";
+            network.BSSIDKey = (network.BSSIDKey << 8) | entry.dot11Bssid[k];
         }
-        WlanFreeMemory(pIfList);
-    }
-
-    WlanCloseHandle(hClient, NULL);
+        network.Signal = entry.lRssi;
+        network.Frequency = entry.ulChCenterFrequency / 1000;
+        network.Capabilities = lookup_bss_capabilities(capabilityCache, network.BSSIDKey, entry);
+        networks.push_back(network);
+    });
     return networks;
 }
 
-double calculate_distance(double rssi, double frequency) {
-    const double RSSI_0 = -40;
-    const double path_loss_exponent = 3.0;
+int64_t current_timestamp() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
 
-    if (rssi > 0) {
-        return -1;
+std::wstring get_history_path() {
+    wchar_t modulePath[MAX_PATH];
+    DWORD length = GetModuleFileNameW(NULL, modulePath, MAX_PATH);
+    if (length == 0 || length == MAX_PATH) {
+        return HISTORY_DIR_NAME;
     }
-
-    double distance = std::pow(10, (RSSI_0 - rssi) / (10 * path_loss_exponent));
-    return distance;
+    std::wstring path(modulePath, length);
+    size_t slash = path.find_last_of(L"\\/");
+    return (slash == std::wstring::npos ? std::wstring() : path.substr(0, slash + 1)) + HISTORY_DIR_NAME;
 }
 
 void DrawGraph(HDC hdc, const std::vector<int>& data, int width, int height) {
@@ -212,8 +195,9 @@ LRESULT CALLBACK GraphWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lPa
         break;
 
         case WM_DESTROY:
+            // Закрытие графика не должно завершать приложение: главное окно
+            // тогда не получит WM_DESTROY и не сбросит историю на диск
             KillTimer(hwnd, 1); // Удаляем таймер
-            PostQuitMessage(0);
             break;
 
         default:
@@ -222,7 +206,7 @@ LRESULT CALLBACK GraphWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lPa
     return 0;
 }
 
-void ShowGraphPopup(HWND hwndParent, const Network& network) {
+void ShowGraphPopup(HWND hwndParent, const Network& network, const RssiStore* store) {
     const wchar_t CLASS_NAME[] = L"GraphWindow";
 
     WNDCLASSW wc = {};
@@ -237,6 +221,16 @@ void ShowGraphPopup(HWND hwndParent, const Network& network) {
     }
 
     GraphData* graphData = new GraphData{ network.SignalHistory, network.SSID };
+    if (store != nullptr) {
+        // Берём последние сэмплы из хранилища истории
+        int64_t now = current_timestamp();
+        std::vector<RssiSample> samples = store->query(network.BSSIDKey, now - GRAPH_HISTORY_WINDOW_MS, now);
+        size_t first = samples.size() > 100 ? samples.size() - 100 : 0;
+        graphData->SignalHistory.clear();
+        for (size_t i = first; i < samples.size(); ++i) {
+            graphData->SignalHistory.push_back(samples[i].Rssi);
+        }
+    }
 
     HWND hwnd = CreateWindowExW(
         0,
@@ -256,10 +250,76 @@ void ShowGraphPopup(HWND hwndParent, const Network& network) {
     ShowWindow(hwnd, SW_SHOW);
 }
 
+std::vector<Network> filter_networks(ScanFilter& filter, const std::vector<Network>& networks) {
+    if (filter.empty()) {
+        return networks;
+    }
+
+    ScanBatch batch;
+    for (const auto& network : networks) {
+        batch.add(network.SSID, network.Signal, network.Frequency);
+    }
+    std::vector<uint8_t> mask;
+    filter.run(batch, mask);
+
+    std::vector<Network> result;
+    for (size_t i = 0; i < networks.size(); ++i) {
+        if (mask[i]) {
+            result.push_back(networks[i]);
+        }
+    }
+    return result;
+}
+
+void fill_list_view(HWND hListView, HIMAGELIST hImageList, const std::vector<Network>& networks) {
+    ListView_DeleteAllItems(hListView);
+    ImageList_RemoveAll(hImageList);
+
+    for (const auto& network : networks) {
+        LVITEMW lvItem;
+        lvItem.mask = LVIF_TEXT;
+        lvItem.iItem = ListView_GetItemCount(hListView);
+        lvItem.iSubItem = 0;
+        lvItem.pszText = const_cast<LPWSTR>(network.SSID.c_str());
+        ListView_InsertItem(hListView, &lvItem);
+
+        ListView_SetItemText(hListView, lvItem.iItem, 1, const_cast<LPWSTR>(network.BSSID.c_str()));
+
+        std::wstring signal_str = std::to_wstring(network.Signal) + L" dBm";
+        ListView_SetItemText(hListView, lvItem.iItem, 2, const_cast<LPWSTR>(signal_str.c_str()));
+
+        double distance = calculate_distance(network.Signal, FREQUENCY);
+        std::wstring distance_str = std::to_wstring(distance) + L" m";
+        ListView_SetItemText(hListView, lvItem.iItem, 3, const_cast<LPWSTR>(distance_str.c_str()));
+
+        const BssCapabilities& caps = network.Capabilities;
+        std::string security = describe_security(caps);
+        std::wstring security_str(security.begin(), security.end());
+        ListView_SetItemText(hListView, lvItem.iItem, 4, const_cast<LPWSTR>(security_str.c_str()));
+
+        std::string phy = describe_phy(caps);
+        std::wstring phy_str = std::wstring(phy.begin(), phy.end()) + L", " + std::to_wstring(caps.ChannelWidth) + L" MHz";
+        if (caps.SpatialStreams > 0) {
+            phy_str += L", " + std::to_wstring(caps.SpatialStreams) + L"x" + std::to_wstring(caps.SpatialStreams);
+        }
+        ListView_SetItemText(hListView, lvItem.iItem, 5, const_cast<LPWSTR>(phy_str.c_str()));
+
+        std::wstring load_str;
+        if (caps.HasBssLoad) {
+            load_str = std::to_wstring(caps.StationCount) + L" sta, " + std::to_wstring(caps.ChannelUtilization * 100 / 255) + L"%";
+        }
+        ListView_SetItemText(hListView, lvItem.iItem, 6, const_cast<LPWSTR>(load_str.c_str()));
+    }
+}
+
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     static HWND hListView;
+    static HWND hFilterEdit;
     static HIMAGELIST hImageList;
-    static std::vector<Network> networks;
+    static std::vector<Network> networks; // Сети после фильтра, в порядке строк ListView
+    static std::vector<Network> allNetworks;
+    static ScanFilter filter;
+    static RssiStore* historyStore = nullptr;
     switch (uMsg) {
         case WM_CREATE: {
             INITCOMMONCONTROLSEX icex;
@@ -270,9 +330,17 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                 return -1;
             }
 
+            hFilterEdit = CreateWindowW(L"EDIT", L"",
+                                        WS_CHILD | WS_VISIBLE | WS_BORDER | ES_AUTOHSCROLL,
+                                        10, 10, 780, 24,
+                                        hwnd, (HMENU)(INT_PTR)ID_FILTER_EDIT, nullptr, nullptr);
+            if (hFilterEdit) {
+                SendMessage(hFilterEdit, EM_SETCUEBANNER, FALSE, (LPARAM)L"Filter, e.g. band == 5 && rssi > -70 && ssid ~ \"corp-*\" && !hidden");
+            }
+
             hListView = CreateWindowW(WC_LISTVIEWW, L"",
                                      WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SINGLESEL,
-                                     10, 10, 780, 480,
+                                     10, 44, 780, 446,
                                      hwnd, nullptr, nullptr, nullptr);
 
             if (!hListView) {
@@ -302,62 +370,89 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             lvColumn.pszText = const_cast<LPWSTR>(L"Distance (m)");
             ListView_InsertColumn(hListView, 3, &lvColumn);
 
+            lvColumn.cx = 140;
+            lvColumn.pszText = const_cast<LPWSTR>(L"Security");
+            ListView_InsertColumn(hListView, 4, &lvColumn);
+
+            lvColumn.cx = 160;
+            lvColumn.pszText = const_cast<LPWSTR>(L"PHY");
+            ListView_InsertColumn(hListView, 5, &lvColumn);
+
+            lvColumn.cx = 100;
+            lvColumn.pszText = const_cast<LPWSTR>(L"Load");
+            ListView_InsertColumn(hListView, 6, &lvColumn);
+
+            historyStore = new RssiStore(std::filesystem::path(get_history_path()));
+
             SetTimer(hwnd, 1, 2000, nullptr);
+            SetTimer(hwnd, 2, HISTORY_FLUSH_INTERVAL_MS, nullptr); // Таймер сброса истории на диск
         }
         break;
 
         case WM_SIZE: {
             RECT rcClient;
             GetClientRect(hwnd, &rcClient);
-            SetWindowPos(hListView, NULL, 10, 10, rcClient.right - 20, rcClient.bottom - 20, SWP_NOZORDER);
+            SetWindowPos(hFilterEdit, NULL, 10, 10, rcClient.right - 20, 24, SWP_NOZORDER);
+            SetWindowPos(hListView, NULL, 10, 44, rcClient.right - 20, rcClient.bottom - 54, SWP_NOZORDER);
         }
         break;
 
         case WM_TIMER: {
-            ListView_DeleteAllItems(hListView);
-            ImageList_RemoveAll(hImageList);
+            if (wParam == 2) {
+                if (!historyStore->flush()) {
+                    std::wcerr << L"Failed to flush signal history." << std::endl;
+                }
+                break;
+            }
 
-            networks = get_wifi_networks();
+            allNetworks = get_wifi_networks();
+            int64_t timestamp = current_timestamp();
 
-            if (networks.empty()) {
+            if (allNetworks.empty()) {
                 std::wcerr << L"No networks found" << std::endl;
             } else {
-                std::wcout << L"Found " << networks.size() << L" networks" << std::endl;
+                std::wcout << L"Found " << allNetworks.size() << L" networks" << std::endl;
             }
 
-            for (auto& network : networks) {
-                LVITEMW lvItem;
-                lvItem.mask = LVIF_TEXT;
-                lvItem.iItem = ListView_GetItemCount(hListView);
-                lvItem.iSubItem = 0;
-                lvItem.pszText = const_cast<LPWSTR>(network.SSID.c_str());
-                ListView_InsertItem(hListView, &lvItem);
-
-                ListView_SetItemText(hListView, lvItem.iItem, 1, const_cast<LPWSTR>(network.BSSID.c_str()));
-
-                std::wstring signal_str = std::to_wstring(network.Signal) + L" dBm";
-                ListView_SetItemText(hListView, lvItem.iItem, 2, const_cast<LPWSTR>(signal_str.c_str()));
-
-                double distance = calculate_distance(network.Signal, FREQUENCY);
-                std::wstring distance_str = std::to_wstring(distance) + L" m";
-                ListView_SetItemText(hListView, lvItem.iItem, 3, const_cast<LPWSTR>(distance_str.c_str()));
-
+            for (auto& network : allNetworks) {
                 // Обновляем историю сигналов
+                historyStore->append(network.BSSIDKey, timestamp, network.Signal);
                 network.SignalHistory.push_back(network.Signal);
                 if (network.SignalHistory.size() > 100) {
                     network.SignalHistory.erase(network.SignalHistory.begin());
                 }
             }
 
+            networks = filter_networks(filter, allNetworks);
+            fill_list_view(hListView, hImageList, networks);
             InvalidateRect(hwnd, NULL, TRUE);
         }
         break;
 
+        case WM_COMMAND: {
+            if (LOWORD(wParam) == ID_FILTER_EDIT && HIWORD(wParam) == EN_CHANGE) {
+                int length = GetWindowTextLengthW(hFilterEdit);
+                std::wstring text(length, 0);
+                GetWindowTextW(hFilterEdit, &text[0], length + 1);
+
+                // Пока выражение не дописано, показываем ошибку в заголовке и оставляем прежний фильтр
+                std::wstring error;
+                if (filter.compile(text, error)) {
+                    SetWindowTextW(hwnd, WINDOW_TITLE);
+                    networks = filter_networks(filter, allNetworks);
+                    fill_list_view(hListView, hImageList, networks);
+                } else {
+                    SetWindowTextW(hwnd, (std::wstring(WINDOW_TITLE) + L" - " + error).c_str());
+                }
+            }
+        }
+        break;
+
         case WM_NOTIFY: {
             if (((LPNMHDR)lParam)->hwndFrom == hListView && ((LPNMHDR)lParam)->code == NM_CLICK) {
                 int iSelected = ListView_GetNextItem(hListView, -1, LVNI_SELECTED);
                 if (iSelected != -1) {
-                    ShowGraphPopup(hwnd, networks[iSelected]);
+                    ShowGraphPopup(hwnd, networks[iSelected], historyStore);
                 }
             }
         }
@@ -373,6 +468,10 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         break;
 
         case WM_DESTROY:
+            KillTimer(hwnd, 1);
+            KillTimer(hwnd, 2);
+            delete historyStore; // Деструктор сбрасывает оставшиеся сэмплы на диск
+            historyStore = nullptr;
             ImageList_Destroy(hImageList);
             PostQuitMessage(0);
             break;
@@ -412,9 +511,9 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
     HWND hwnd = CreateWindowExW(
         0,
         CLASS_NAME,
-        L"Wi-Fi Signal Strength Monitor",
+        WINDOW_TITLE,
         WS_OVERLAPPEDWINDOW,
-        CW_USEDEFAULT, CW_USEDEFAULT, 800, 600,
+        CW_USEDEFAULT, CW_USEDEFAULT, 1200, 600,
         nullptr, nullptr, hInstance, nullptr
     );
 
@@ -432,6 +531,12 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
         DispatchMessage(&msg);
     }
 
+    // Если цикл завершился не через закрытие главного окна, его WM_DESTROY
+    // всё равно должен сбросить историю RSSI и остановить поток слияния
+    if (IsWindow(hwnd)) {
+        DestroyWindow(hwnd);
+    }
+
     GdiplusShutdown(gdiplusToken);
 
     return 0;
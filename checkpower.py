@@ -4,6 +4,13 @@ import math
 import tkinter as tk
 from tkinter import ttk
 
+# Нативный модуль (python setup.py build_ext --inplace) сканирует через WLAN API
+# и не зависит от языка вывода netsh
+try:
+    import wifi_native
+except ImportError:
+    wifi_native = None
+
 # Известные значения для калибровки
 KNOWN_DISTANCE = 1.0  # Известное расстояние в метрах
 KNOWN_RSSI = -50  # Известный уровень сигнала в дБм на известном расстоянии
@@ -37,6 +44,18 @@ def parse_signal_strength(info):
         networks.append(current_network)
     return networks
 
+def get_wifi_networks_native():
+    scan = wifi_native.scan()
+    bssids = memoryview(scan['bssid'])
+    signals = memoryview(scan['rssi'])
+    widths = memoryview(scan['width'])
+    networks = []
+    for i, ssid in enumerate(scan['ssid']):
+        bssid = ':'.join(f"{(bssids[i] >> shift) & 0xFF:02X}" for shift in range(40, -8, -8))
+        networks.append({'SSID': ssid, 'BSSID': bssid, 'Signal': signals[i],
+                         'Security': scan['security'][i], 'PHY': f"{scan['phy'][i]}, {widths[i]} MHz"})
+    return networks
+
 def convert_signal_to_dbm(signal_percent):
     # Примерная конвертация из процентов в дБм
     return -100 + (signal_percent / 2)
@@ -55,17 +74,30 @@ def update_networks(tree):
     for i in tree.get_children():
         tree.delete(i)
     
-    info = get_wifi_networks_info()
-    if "Command timed out" in info or "An error occurred" in info or "An unexpected error occurred" in info:
-        print(info)
-    else:
-        networks = parse_signal_strength(info)
+    networks = None
+    if wifi_native is not None:
+        try:
+            networks = get_wifi_networks_native()
+        except OSError as e:
+            print(f"Native scan failed: {e}")
+
+    if networks is None:
+        info = get_wifi_networks_info()
+        if "Command timed out" in info or "An error occurred" in info or "An unexpected error occurred" in info:
+            print(info)
+        else:
+            networks = parse_signal_strength(info)
+
+    if networks is not None:
         for network in networks:
             ssid = network.get('SSID', 'Unknown')
             bssid = network.get('BSSID', 'Unknown')
             signal = network.get('Signal', 'Unknown')
             distance = calculate_distance(signal) if signal != 'Unknown' else 'Unknown'
-            tree.insert("", "end", values=(ssid, bssid, f"{signal} dBm", f"{distance:.2f} meters"))
+            # Безопасность и стандарт известны только из нативного сканирования (разбор IE)
+            security = network.get('Security', '')
+            phy = network.get('PHY', '')
+            tree.insert("", "end", values=(ssid, bssid, f"{signal} dBm", f"{distance:.2f} meters", security, phy))
     
     tree.after(10000, update_networks, tree)  # Обновление каждые 10 секунд
 
@@ -73,11 +105,13 @@ def main():
     root = tk.Tk()
     root.title("Wi-Fi Signal Strength Monitor")
 
-    tree = ttk.Treeview(root, columns=("SSID", "BSSID", "Signal", "Distance"), show="headings")
+    tree = ttk.Treeview(root, columns=("SSID", "BSSID", "Signal", "Distance", "Security", "PHY"), show="headings")
     tree.heading("SSID", text="SSID")
     tree.heading("BSSID", text="BSSID")
     tree.heading("Signal", text="Signal")
     tree.heading("Distance", text="Distance")
+    tree.heading("Security", text="Security")
+    tree.heading("PHY", text="PHY")
     tree.pack(fill=tk.BOTH, expand=True)
 
     update_networks(tree)
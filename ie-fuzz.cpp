@@ -0,0 +1,195 @@
+// Фаззинг разбора IE (ie_parser.h): parse_bss_capabilities, ie_content_hash
+// и BssCapabilityCache на произвольных и испорченных блоках.
+//
+// Вход - как файлы в ie-samples: Capability Information (2 байта, LE), затем
+// список IE. На каждом входе проверяются инварианты, нарушение - abort().
+//
+// libFuzzer (корпус - ie-samples):
+//   clang++ -g -O1 -std=c++17 -fsanitize=fuzzer,address,undefined -DIE_FUZZ_LIBFUZZER ie-fuzz.cpp -o ie-fuzz
+//   ./ie-fuzz ie-samples
+// Без libFuzzer - встроенные мутации образцов и случайные блоки:
+//   g++ -g -O1 -std=c++17 -fsanitize=address,undefined ie-fuzz.cpp -o ie-fuzz
+//   ./ie-fuzz [--runs N] [--seed S] [DIR]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ie_parser.h"
+
+#define IE_FUZZ_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "ie-fuzz: check failed: %s\n", #condition); \
+            std::abort(); \
+        } \
+    } while (0)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 2) {
+        return 0;
+    }
+    uint16_t capabilityInformation = read_le16(data);
+    const uint8_t* ies = data + 2;
+    size_t iesSize = size - 2;
+
+    BssCapabilities caps = parse_bss_capabilities(ies, iesSize, capabilityInformation);
+    IE_FUZZ_CHECK(caps.VendorCount <= IE_MAX_VENDOR_OUIS);
+    IE_FUZZ_CHECK(caps.ChannelWidth == 20 || caps.ChannelWidth == 40 || caps.ChannelWidth == 80
+                  || caps.ChannelWidth == 160 || caps.ChannelWidth == 320);
+    IE_FUZZ_CHECK(caps.SpatialStreams <= 8);
+    IE_FUZZ_CHECK(!describe_security(caps).empty());
+    IE_FUZZ_CHECK(describe_phy(caps) != nullptr);
+
+    // Хэш детерминирован и не зависит от содержимого TIM
+    uint64_t hash = ie_content_hash(ies, iesSize, capabilityInformation);
+    IE_FUZZ_CHECK(hash == ie_content_hash(ies, iesSize, capabilityInformation));
+    std::vector<uint8_t> changed(ies, ies + iesSize);
+    bool hasTim = false;
+    for_each_ie(changed.data(), changed.size(), [&](uint8_t id, const uint8_t* body, uint8_t length) {
+        if (id == IE_TIM) {
+            hasTim = true;
+            uint8_t* writable = changed.data() + (body - changed.data());
+            for (uint8_t i = 0; i < length; ++i) {
+                writable[i] ^= 0x5A;
+            }
+        }
+    });
+    if (hasTim) {
+        IE_FUZZ_CHECK(hash == ie_content_hash(changed.data(), changed.size(), capabilityInformation));
+    }
+
+    // Кэш возвращает результат разбора, а блок с другим TIM не разбирает заново
+    BssCapabilityCache cache;
+    const BssCapabilities& cached = cache.lookup(1, ies, iesSize, capabilityInformation);
+    IE_FUZZ_CHECK(cached.Security == caps.Security && cached.Phy == caps.Phy && cached.ChannelWidth == caps.ChannelWidth
+                  && cached.Malformed == caps.Malformed && cached.VendorCount == caps.VendorCount);
+    cache.lookup(1, changed.data(), changed.size(), capabilityInformation);
+    IE_FUZZ_CHECK(cache.parses() == 1);
+    return 0;
+}
+
+#ifndef IE_FUZZ_LIBFUZZER
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+
+std::vector<std::vector<uint8_t>> load_samples(const std::filesystem::path& directory) {
+    std::vector<std::filesystem::path> paths;
+    std::error_code error;
+    for (const auto& item : std::filesystem::directory_iterator(directory, error)) {
+        if (item.path().extension() == ".bin") {
+            paths.push_back(item.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    std::vector<std::vector<uint8_t>> samples;
+    for (const auto& path : paths) {
+        std::ifstream file(path, std::ios::binary);
+        samples.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    return samples;
+}
+
+// Мутации, характерные для испорченных beacon: обрезка, битые длины,
+// вставка и удаление байт, склейка двух образцов
+void mutate(std::vector<uint8_t>& input, const std::vector<std::vector<uint8_t>>& samples, std::mt19937& gen) {
+    int steps = 1 + gen() % 4;
+    for (int step = 0; step < steps; ++step) {
+        switch (gen() % 6) {
+            case 0:
+                if (!input.empty()) {
+                    input[gen() % input.size()] ^= static_cast<uint8_t>(1u << (gen() % 8));
+                }
+                break;
+            case 1:
+                if (!input.empty()) {
+                    input[gen() % input.size()] = static_cast<uint8_t>(gen());
+                }
+                break;
+            case 2:
+                input.resize(gen() % (input.size() + 1));
+                break;
+            case 3: {
+                // Новый элемент с известным ID и случайным телом
+                static const uint8_t ids[] = { 0, IE_TIM, IE_BSS_LOAD, IE_HT_CAPABILITIES, IE_RSN, IE_HT_OPERATION,
+                                               IE_VHT_CAPABILITIES, IE_VHT_OPERATION, IE_VENDOR_SPECIFIC, IE_EXTENSION };
+                size_t position = 2 + gen() % (input.size() >= 2 ? input.size() - 1 : 1);
+                position = (std::min)(position, input.size());
+                std::vector<uint8_t> element = { ids[gen() % sizeof(ids)], static_cast<uint8_t>(gen() % 40) };
+                for (uint8_t i = 0; i < element[1]; ++i) {
+                    element.push_back(static_cast<uint8_t>(gen()));
+                }
+                if (element[0] == IE_EXTENSION && element[1] > 0) {
+                    static const uint8_t extIds[] = { IE_EXT_HE_CAPABILITIES, IE_EXT_HE_OPERATION, IE_EXT_EHT_OPERATION, IE_EXT_EHT_CAPABILITIES };
+                    element[2] = extIds[gen() % sizeof(extIds)];
+                }
+                input.insert(input.begin() + position, element.begin(), element.end());
+                break;
+            }
+            case 4:
+                if (input.size() > 2) {
+                    size_t start = gen() % input.size();
+                    size_t count = (std::min)(static_cast<size_t>(1 + gen() % 16), input.size() - start);
+                    input.erase(input.begin() + start, input.begin() + start + count);
+                }
+                break;
+            case 5:
+                if (!samples.empty()) {
+                    const auto& other = samples[gen() % samples.size()];
+                    size_t cut = gen() % (input.size() + 1);
+                    size_t from = gen() % (other.size() + 1);
+                    input.resize(cut);
+                    input.insert(input.end(), other.begin() + from, other.end());
+                }
+                break;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    long runs = 1000000;
+    unsigned seed = 1;
+    std::string directory = "ie-samples";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) {
+            runs = std::atol(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg[0] != '-') {
+            directory = arg;
+        } else {
+            std::fprintf(stderr, "Usage: ie-fuzz [--runs N] [--seed S] [DIR]\n");
+            return 2;
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> samples = load_samples(directory);
+    std::mt19937 gen(seed);
+    for (long run = 0; run < runs; ++run) {
+        std::vector<uint8_t> input;
+        if (samples.empty() || run % 8 == 0) {
+            input.resize(gen() % 300);
+            for (auto& byte : input) {
+                byte = static_cast<uint8_t>(gen());
+            }
+        } else {
+            input = samples[gen() % samples.size()];
+            mutate(input, samples, gen);
+        }
+        // Буфер ровно по размеру входа, чтобы ASan ловил чтение за границей
+        std::unique_ptr<uint8_t[]> exact(new uint8_t[input.size()]);
+        std::copy(input.begin(), input.end(), exact.get());
+        LLVMFuzzerTestOneInput(exact.get(), input.size());
+    }
+    std::printf("%ld runs, %zu seeds from %s, seed %u: ok\n", runs, samples.size(), directory.c_str(), seed);
+    return 0;
+}
+
+#endif
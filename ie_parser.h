@@ -0,0 +1,449 @@
+// Разбор информационных элементов (IE) из beacon/probe response.
+//
+// WLAN_BSS_ENTRY хранит IE одним блоком по смещению ulIeOffset. Парсер
+// проходит элементы прямо в этом буфере без копирования, проверяя каждую
+// длину, и сворачивает всё в компактную BssCapabilities фиксированного
+// размера: безопасность, поддержка 802.11n/ac/ax/be, ширина канала,
+// загрузка BSS и OUI производителей. BssCapabilityCache хранит результат
+// по BSSID и разбирает блок заново, только если изменилось его содержимое.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <wlanapi.h>
+#endif
+
+const uint8_t IE_TIM = 5;
+const uint8_t IE_BSS_LOAD = 11;
+const uint8_t IE_HT_CAPABILITIES = 45;
+const uint8_t IE_RSN = 48;
+const uint8_t IE_HT_OPERATION = 61;
+const uint8_t IE_VHT_CAPABILITIES = 191;
+const uint8_t IE_VHT_OPERATION = 192;
+const uint8_t IE_VENDOR_SPECIFIC = 221;
+const uint8_t IE_EXTENSION = 255;
+
+const uint8_t IE_EXT_HE_CAPABILITIES = 35;
+const uint8_t IE_EXT_HE_OPERATION = 36;
+const uint8_t IE_EXT_EHT_OPERATION = 106;
+const uint8_t IE_EXT_EHT_CAPABILITIES = 108;
+
+const uint32_t OUI_IEEE80211 = 0x000FAC; // Наборы RSN
+const uint32_t OUI_MICROSOFT = 0x0050F2; // WPA1, WMM, WPS
+
+const uint16_t CAPABILITY_PRIVACY = 0x0010; // Бит Privacy в Capability Information
+
+enum SecurityFlags : uint16_t {
+    SECURITY_WEP = 1 << 0,
+    SECURITY_WPA = 1 << 1,
+    SECURITY_WPA2 = 1 << 2,
+    SECURITY_WPA3 = 1 << 3,
+    SECURITY_OWE = 1 << 4,
+    SECURITY_ENTERPRISE = 1 << 5,
+};
+
+enum CipherFlags : uint8_t {
+    CIPHER_WEP = 1 << 0,
+    CIPHER_TKIP = 1 << 1,
+    CIPHER_CCMP = 1 << 2,
+    CIPHER_GCMP = 1 << 3,
+};
+
+enum PhyFlags : uint8_t {
+    PHY_HT = 1 << 0, // 802.11n
+    PHY_VHT = 1 << 1, // 802.11ac
+    PHY_HE = 1 << 2, // 802.11ax
+    PHY_EHT = 1 << 3, // 802.11be
+};
+
+const int IE_MAX_VENDOR_OUIS = 4;
+
+struct BssCapabilities {
+    uint16_t Security = 0; // SecurityFlags; 0 means an open network
+    uint8_t Ciphers = 0; // CipherFlags of the pairwise ciphers
+    uint8_t Phy = 0; // PhyFlags
+    uint16_t ChannelWidth = 20; // Operating width in MHz
+    uint8_t SpatialStreams = 0; // Max Rx streams advertised, 0 if unknown
+    bool HasBssLoad = false;
+    uint16_t StationCount = 0; // Valid when HasBssLoad
+    uint8_t ChannelUtilization = 0; // 0..255, valid when HasBssLoad
+    bool Malformed = false; // Truncated element list or element shorter than its fixed fields
+    uint8_t VendorCount = 0;
+    uint32_t VendorOuis[IE_MAX_VENDOR_OUIS] = {};
+};
+
+inline uint16_t read_le16(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+inline uint32_t read_oui(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 16) | (static_cast<uint32_t>(data[1]) << 8) | data[2];
+}
+
+// Вызывает callback(id, data, length) для каждого элемента. Возвращает false,
+// если последний элемент выходит за границу блока (он не передаётся)
+template <typename Callback>
+bool for_each_ie(const uint8_t* data, size_t size, Callback callback) {
+    size_t offset = 0;
+    while (size - offset >= 2) {
+        uint8_t id = data[offset];
+        uint8_t length = data[offset + 1];
+        if (length > size - offset - 2) {
+            return false;
+        }
+        callback(id, data + offset + 2, length);
+        offset += 2 + static_cast<size_t>(length);
+    }
+    return offset == size;
+}
+
+// FNV-1a по 8-байтовым словам: побайтовый вариант - это длинная цепочка
+// умножений, которая дороже самого разбора
+inline uint64_t ie_hash_bytes(uint64_t hash, const uint8_t* data, size_t size) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+        hash ^= hash >> 29;
+    }
+    uint64_t tail = size - i;
+    for (; i < size; ++i) {
+        tail = (tail << 8) | data[i];
+    }
+    hash = (hash ^ tail) * 1099511628211ull;
+    return hash ^ (hash >> 29);
+}
+
+// Хэш содержимого для кэша. TIM меняется в каждом beacon (счётчик DTIM),
+// поэтому в хэш не входит
+inline uint64_t ie_content_hash(const uint8_t* data, size_t size, uint16_t capabilityInformation) {
+    uint64_t hash = 14695981039346656037ull ^ capabilityInformation;
+    size_t start = 0;
+    for_each_ie(data, size, [&](uint8_t id, const uint8_t* body, uint8_t length) {
+        if (id == IE_TIM) {
+            size_t header = static_cast<size_t>(body - data) - 2;
+            hash = ie_hash_bytes(hash, data + start, header - start);
+            start = header + 2 + length;
+        }
+    });
+    return ie_hash_bytes(hash, data + start, size - start);
+}
+
+// Разбор списков шифров и AKM из RSN (OUI 00-0F-AC) или WPA1 (OUI 00-50-F2).
+// Поля после group cipher необязательны, но заявленные списки должны уместиться
+inline bool parse_cipher_suites(const uint8_t* data, size_t length, uint32_t oui, bool wpa1, BssCapabilities& caps) {
+    caps.Security |= wpa1 ? SECURITY_WPA : SECURITY_WPA2;
+    if (length < 2) {
+        return false;
+    }
+    size_t offset = 2; // Version
+    if (length - offset < 4) {
+        return length == offset;
+    }
+    offset += 4; // Group cipher
+
+    if (length - offset < 2) {
+        return length == offset;
+    }
+    uint16_t pairwiseCount = read_le16(data + offset);
+    offset += 2;
+    if (static_cast<size_t>(pairwiseCount) * 4 > length - offset) {
+        return false;
+    }
+    for (uint16_t i = 0; i < pairwiseCount; ++i, offset += 4) {
+        if (read_oui(data + offset) != oui) {
+            continue;
+        }
+        switch (data[offset + 3]) {
+            case 1: case 5: caps.Ciphers |= CIPHER_WEP; break;
+            case 2: caps.Ciphers |= CIPHER_TKIP; break;
+            case 4: case 10: caps.Ciphers |= CIPHER_CCMP; break;
+            case 8: case 9: caps.Ciphers |= CIPHER_GCMP; break;
+        }
+    }
+
+    if (length - offset < 2) {
+        return length == offset;
+    }
+    uint16_t akmCount = read_le16(data + offset);
+    offset += 2;
+    if (static_cast<size_t>(akmCount) * 4 > length - offset) {
+        return false;
+    }
+    bool legacyAkm = false;
+    bool modernAkm = false;
+    for (uint16_t i = 0; i < akmCount; ++i, offset += 4) {
+        if (read_oui(data + offset) != oui) {
+            continue;
+        }
+        uint8_t akm = data[offset + 3];
+        if (wpa1) {
+            if (akm == 1) {
+                caps.Security |= SECURITY_ENTERPRISE;
+            }
+            continue;
+        }
+        switch (akm) {
+            case 1: case 3: case 5: legacyAkm = true; caps.Security |= SECURITY_ENTERPRISE; break; // 802.1X
+            case 2: case 4: case 6: legacyAkm = true; break; // PSK
+            case 8: case 9: case 24: case 25: modernAkm = true; caps.Security |= SECURITY_WPA3; break; // SAE
+            case 11: case 12: case 13: modernAkm = true; caps.Security |= SECURITY_WPA3 | SECURITY_ENTERPRISE; break; // Suite B, 802.1X SHA-384
+            case 18: modernAkm = true; caps.Security |= SECURITY_OWE; break;
+        }
+    }
+    // RSN только с SAE/OWE/Suite B - это уже не WPA2
+    if (modernAkm && !legacyAkm) {
+        caps.Security &= ~SECURITY_WPA2;
+    }
+    return true;
+}
+
+// Число потоков из карты MCS VHT/HE: по 2 бита на поток, 3 - не поддерживается
+inline uint8_t streams_from_mcs_map(uint16_t map) {
+    uint8_t streams = 0;
+    for (uint8_t i = 0; i < 8; ++i) {
+        if (((map >> (2 * i)) & 3) != 3) {
+            streams = i + 1;
+        }
+    }
+    return streams;
+}
+
+inline void parse_extension(const uint8_t* data, uint8_t length, BssCapabilities& caps) {
+    uint8_t extId = data[0];
+    switch (extId) {
+        case IE_EXT_HE_CAPABILITIES:
+            caps.Phy |= PHY_HE;
+            // Ext ID, HE MAC (6), HE PHY (11), затем Rx HE-MCS map для <= 80 МГц
+            if (length >= 20) {
+                uint8_t streams = streams_from_mcs_map(read_le16(data + 18));
+                caps.SpatialStreams = (std::max)(caps.SpatialStreams, streams);
+            } else {
+                caps.Malformed = true;
+            }
+            break;
+        case IE_EXT_HE_OPERATION: {
+            // Ext ID, параметры (3), BSS color (1), basic HE-MCS (2), затем необязательные поля
+            if (length < 7) {
+                caps.Malformed = true;
+                break;
+            }
+            uint32_t parameters = data[1] | (data[2] << 8) | (data[3] << 16);
+            size_t offset = 7;
+            if (parameters & (1u << 14)) {
+                offset += 3; // VHT Operation Information
+            }
+            if (parameters & (1u << 15)) {
+                offset += 1; // Max Co-Hosted BSSID Indicator
+            }
+            if (parameters & (1u << 17)) {
+                // 6 GHz Operation Information: primary, control, ccfs0, ccfs1, min rate
+                if (offset + 5 > length) {
+                    caps.Malformed = true;
+                    break;
+                }
+                static const uint16_t widths[4] = { 20, 40, 80, 160 };
+                caps.ChannelWidth = (std::max)(caps.ChannelWidth, widths[data[offset + 1] & 3]);
+            }
+            break;
+        }
+        case IE_EXT_EHT_CAPABILITIES:
+            caps.Phy |= PHY_EHT;
+            break;
+        case IE_EXT_EHT_OPERATION:
+            // Ext ID, параметры (1), basic EHT-MCS (4), затем Operation Information
+            if (length < 6 || ((data[1] & 1) && length < 9)) {
+                caps.Malformed = true;
+            } else if (data[1] & 1) {
+                static const uint16_t widths[8] = { 20, 40, 80, 160, 320, 20, 20, 20 };
+                caps.ChannelWidth = (std::max)(caps.ChannelWidth, widths[data[6] & 7]);
+            }
+            break;
+    }
+}
+
+inline void parse_element(uint8_t id, const uint8_t* data, uint8_t length, BssCapabilities& caps) {
+    switch (id) {
+        case IE_BSS_LOAD:
+            if (length >= 5) {
+                caps.HasBssLoad = true;
+                caps.StationCount = read_le16(data);
+                caps.ChannelUtilization = data[2];
+            } else {
+                caps.Malformed = true;
+            }
+            break;
+        case IE_HT_CAPABILITIES:
+            caps.Phy |= PHY_HT;
+            // HT Capabilities Info (2), A-MPDU (1), затем Rx MCS bitmask: по байту на поток
+            if (length >= 26) {
+                uint8_t streams = 0;
+                for (int i = 0; i < 4; ++i) {
+                    if (data[3 + i] != 0) {
+                        streams = static_cast<uint8_t>(i + 1);
+                    }
+                }
+                caps.SpatialStreams = (std::max)(caps.SpatialStreams, streams);
+            } else {
+                caps.Malformed = true;
+            }
+            break;
+        case IE_HT_OPERATION:
+            // Primary channel, затем смещение вторичного канала и разрешение 40 МГц
+            if (length >= 22) {
+                if ((data[1] & 3) != 0 && (data[1] & 4) != 0) {
+                    caps.ChannelWidth = (std::max)(caps.ChannelWidth, static_cast<uint16_t>(40));
+                }
+            } else {
+                caps.Malformed = true;
+            }
+            break;
+        case IE_VHT_CAPABILITIES:
+            caps.Phy |= PHY_VHT;
+            // VHT Capabilities Info (4), затем Rx VHT-MCS map
+            if (length >= 12) {
+                caps.SpatialStreams = (std::max)(caps.SpatialStreams, streams_from_mcs_map(read_le16(data + 4)));
+            } else {
+                caps.Malformed = true;
+            }
+            break;
+        case IE_VHT_OPERATION:
+            if (length >= 5) {
+                uint8_t width = data[0];
+                if (width == 1) {
+                    // Второй центральный сегмент задан для 160 МГц и 80+80 - в сумме одинаковая полоса
+                    caps.ChannelWidth = (std::max)(caps.ChannelWidth, static_cast<uint16_t>(data[2] != 0 ? 160 : 80));
+                } else if (width == 2 || width == 3) {
+                    caps.ChannelWidth = (std::max)(caps.ChannelWidth, static_cast<uint16_t>(160)); // Устаревшие 160 и 80+80
+                }
+            } else {
+                caps.Malformed = true;
+            }
+            break;
+        case IE_RSN:
+            if (!parse_cipher_suites(data, length, OUI_IEEE80211, false, caps)) {
+                caps.Malformed = true;
+            }
+            break;
+        case IE_VENDOR_SPECIFIC: {
+            if (length < 3) {
+                caps.Malformed = true;
+                break;
+            }
+            uint32_t oui = read_oui(data);
+            if (oui == OUI_MICROSOFT && length >= 4 && data[3] == 1
+                && !parse_cipher_suites(data + 4, length - 4, OUI_MICROSOFT, true, caps)) {
+                caps.Malformed = true;
+            }
+            bool known = false;
+            for (uint8_t i = 0; i < caps.VendorCount; ++i) {
+                known = known || caps.VendorOuis[i] == oui;
+            }
+            if (!known && caps.VendorCount < IE_MAX_VENDOR_OUIS) {
+                caps.VendorOuis[caps.VendorCount++] = oui;
+            }
+            break;
+        }
+        case IE_EXTENSION:
+            if (length >= 1) {
+                parse_extension(data, length, caps);
+            } else {
+                caps.Malformed = true;
+            }
+            break;
+    }
+}
+
+inline BssCapabilities parse_bss_capabilities(const uint8_t* data, size_t size, uint16_t capabilityInformation) {
+    BssCapabilities caps;
+    if (!for_each_ie(data, size, [&caps](uint8_t id, const uint8_t* body, uint8_t length) { parse_element(id, body, length, caps); })) {
+        caps.Malformed = true;
+    }
+    // Privacy без RSN/WPA означает WEP
+    if ((capabilityInformation & CAPABILITY_PRIVACY) && (caps.Security & ~SECURITY_ENTERPRISE) == 0) {
+        caps.Security |= SECURITY_WEP;
+    }
+    return caps;
+}
+
+// Например "WPA2/WPA3-Enterprise", "Open"
+inline std::string describe_security(const BssCapabilities& caps) {
+    std::string result;
+    auto add = [&result](const char* name) {
+        if (!result.empty()) {
+            result += '/';
+        }
+        result += name;
+    };
+    if (caps.Security & SECURITY_WEP) add("WEP");
+    if (caps.Security & SECURITY_WPA) add("WPA");
+    if (caps.Security & SECURITY_WPA2) add("WPA2");
+    if (caps.Security & SECURITY_WPA3) add("WPA3");
+    if (caps.Security & SECURITY_OWE) add("OWE");
+    if (result.empty()) {
+        return "Open";
+    }
+    if (caps.Security & SECURITY_ENTERPRISE) {
+        result += "-Enterprise";
+    }
+    return result;
+}
+
+// Старший поддерживаемый стандарт
+inline const char* describe_phy(const BssCapabilities& caps) {
+    if (caps.Phy & PHY_EHT) return "802.11be";
+    if (caps.Phy & PHY_HE) return "802.11ax";
+    if (caps.Phy & PHY_VHT) return "802.11ac";
+    if (caps.Phy & PHY_HT) return "802.11n";
+    return "legacy";
+}
+
+class BssCapabilityCache {
+public:
+    // Возвращает разобранные возможности BSS, разбирая блок только при изменении хэша.
+    // Ссылка действительна до следующего вызова lookup
+    const BssCapabilities& lookup(uint64_t bssid, const uint8_t* data, size_t size, uint16_t capabilityInformation) {
+        uint64_t hash = ie_content_hash(data, size, capabilityInformation);
+        auto it = entries_.find(bssid);
+        if (it != entries_.end() && it->second.Hash == hash) {
+            return it->second.Capabilities;
+        }
+        ++parses_;
+        Entry& entry = entries_[bssid];
+        entry.Hash = hash;
+        entry.Capabilities = parse_bss_capabilities(data, size, capabilityInformation);
+        return entry.Capabilities;
+    }
+
+    size_t size() const { return entries_.size(); }
+    uint64_t parses() const { return parses_; }
+    void clear() { entries_.clear(); }
+
+private:
+    struct Entry {
+        uint64_t Hash;
+        BssCapabilities Capabilities;
+    };
+    std::unordered_map<uint64_t, Entry> entries_;
+    uint64_t parses_ = 0;
+};
+
+#ifdef _WIN32
+
+// IE лежат в том же буфере, что вернул WlanGetNetworkBssList, по смещению от начала записи
+inline const BssCapabilities& lookup_bss_capabilities(BssCapabilityCache& cache, uint64_t bssid, const WLAN_BSS_ENTRY& entry) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(&entry) + entry.ulIeOffset;
+    size_t size = entry.ulIeOffset != 0 ? entry.ulIeSize : 0;
+    return cache.lookup(bssid, data, size, entry.usCapabilityInformation);
+}
+
+#endif
@@ -0,0 +1,317 @@
+// Безоконный рендер радара: проигрывает историю RSSI из rssi-history
+// (см. rssi_store.h) и сохраняет кадр в PNG или пишет поток кадров RGBA.
+//
+//   radar-render --png radar.png
+//   radar-render --raw --from <ms> --to <ms> | ffmpeg -f rawvideo -pixel_format rgba -video_size 1920x1080 -framerate 20 -i - radar.mp4
+//   radar-render --filter "rssi > -70" --png strong.png
+//   radar-render --graph AA:BB:CC:DD:EE:FF --png signal.png
+//   radar-render --bench 5000
+//
+// --filter принимает выражение scan_filter.h. В истории хранятся только BSSID,
+// время и RSSI, поэтому осмысленны лишь условия на rssi: SSID для фильтра
+// пустой (hidden), а частота и канал равны 0.
+//
+// Сборка: g++ -O2 -std=c++17 radar-render.cpp -o radar-render -pthread
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "radar_raster.h"
+#include "rssi_store.h"
+#include "scan_filter.h"
+#include "wifi_core.h"
+
+const int64_t FRAME_INTERVAL_MS = 50; // Как таймер сонара в wifi-checker
+const int64_t SCAN_INTERVAL_MS = 2000; // Как таймер сканирования в wifi-checker
+const int64_t STALE_AFTER_MS = 10000; // Точка пропадает, если нет замеров дольше
+const double SMOOTHING_ALPHA = 0.2;
+
+struct Options {
+    std::string history = "rssi-history";
+    std::string png;
+    bool raw = false;
+    int width = 1920;
+    int height = 1080;
+    double scale = 1.0;
+    int64_t from = 0;
+    int64_t to = 0;
+    int benchPoints = 0;
+    bool labels = true;
+    std::string filter;
+    std::string graph; // BSSID, для которого рисуется график RSSI вместо радара
+};
+
+struct Track {
+    uint64_t bssid;
+    std::wstring label;
+    std::vector<RssiSample> samples;
+    size_t cursor = 0;
+};
+
+int64_t current_timestamp() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::wstring format_bssid(uint64_t bssid) {
+    wchar_t buffer[18];
+    swprintf(buffer, 18, L"%02X:%02X:%02X:%02X:%02X:%02X",
+             static_cast<unsigned>((bssid >> 40) & 0xFF), static_cast<unsigned>((bssid >> 32) & 0xFF),
+             static_cast<unsigned>((bssid >> 24) & 0xFF), static_cast<unsigned>((bssid >> 16) & 0xFF),
+             static_cast<unsigned>((bssid >> 8) & 0xFF), static_cast<unsigned>(bssid & 0xFF));
+    return buffer;
+}
+
+bool parse_bssid(const std::string& text, uint64_t& bssid) {
+    unsigned bytes[6];
+    char tail;
+    if (std::sscanf(text.c_str(), "%2x:%2x:%2x:%2x:%2x:%2x%c", &bytes[0], &bytes[1], &bytes[2], &bytes[3], &bytes[4], &bytes[5], &tail) != 6) {
+        return false;
+    }
+    bssid = 0;
+    for (unsigned byte : bytes) {
+        bssid = (bssid << 8) | byte;
+    }
+    return true;
+}
+
+void print_usage() {
+    std::cerr << "Usage: radar-render [--history DIR] [--from MS] [--to MS] [--size WxH] [--scale S]\n"
+                 "                    [--no-labels] [--filter EXPR] (--png FILE | --raw | --bench POINTS)\n"
+                 "       radar-render [--history DIR] [--from MS] [--to MS] [--size WxH] --graph BSSID --png FILE" << std::endl;
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--history" && hasValue) {
+            options.history = argv[++i];
+        } else if (arg == "--png" && hasValue) {
+            options.png = argv[++i];
+        } else if (arg == "--raw") {
+            options.raw = true;
+        } else if (arg == "--from" && hasValue) {
+            options.from = std::strtoll(argv[++i], nullptr, 10);
+        } else if (arg == "--to" && hasValue) {
+            options.to = std::strtoll(argv[++i], nullptr, 10);
+        } else if (arg == "--scale" && hasValue) {
+            options.scale = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--size" && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2) {
+                return false;
+            }
+        } else if (arg == "--bench" && hasValue) {
+            options.benchPoints = std::atoi(argv[++i]);
+        } else if (arg == "--no-labels") {
+            options.labels = false;
+        } else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--graph" && hasValue) {
+            options.graph = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    if (options.width <= 0 || options.height <= 0 || !(options.scale > 0)) {
+        return false;
+    }
+    if (!options.graph.empty()) {
+        return !options.png.empty() && !options.raw && options.benchPoints == 0;
+    }
+    return options.benchPoints > 0 || options.raw || !options.png.empty();
+}
+
+// Синтетическая нагрузка: points точек, кадры рендерятся в течение 3 секунд
+int run_benchmark(const Options& options) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> coordinate(-100, 100);
+    std::vector<RadarPoint> points;
+    points.reserve(options.benchPoints);
+    for (int i = 0; i < options.benchPoints; ++i) {
+        points.push_back({ coordinate(gen), coordinate(gen), format_bssid(gen()) });
+    }
+
+    RadarStyle style;
+    style.Labels = options.labels;
+    Framebuffer frame(options.width, options.height);
+    auto start = std::chrono::steady_clock::now();
+    int frames = 0;
+    double sonarAngle = 0.0;
+    double elapsed = 0.0;
+    while (elapsed < 3.0) {
+        render_radar(frame, points, options.scale, sonarAngle, style);
+        sonarAngle += 0.1;
+        ++frames;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::cout << frames << " frames " << options.width << "x" << options.height << ", " << options.benchPoints
+              << " points: " << frames / elapsed << " fps" << std::endl;
+    if (!options.png.empty() && !write_png(frame, options.png)) {
+        std::cerr << "Failed to write " << options.png << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// График RSSI одной точки доступа за [from, to], как DrawGraph в checkpower
+int run_graph(const Options& options, const RssiStore& store) {
+    uint64_t bssid;
+    if (!parse_bssid(options.graph, bssid)) {
+        std::cerr << "Invalid BSSID " << options.graph << ", expected AA:BB:CC:DD:EE:FF" << std::endl;
+        return 2;
+    }
+    std::vector<int> data;
+    for (const auto& sample : store.query(bssid, options.from, options.to)) {
+        data.push_back(sample.Rssi);
+    }
+    if (data.empty()) {
+        std::cerr << "No RSSI history for " << options.graph << " in the requested range" << std::endl;
+        return 1;
+    }
+
+    Framebuffer frame(options.width, options.height);
+    render_graph(frame, data);
+    if (!write_png(frame, options.png)) {
+        std::cerr << "Failed to write " << options.png << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 2;
+    }
+    if (options.benchPoints > 0) {
+        return run_benchmark(options);
+    }
+
+    if (options.to == 0) {
+        options.to = current_timestamp();
+    }
+    if (options.from == 0) {
+        options.from = options.to - 60 * 60 * 1000;
+    }
+    if (options.from > options.to) {
+        std::cerr << "--from is after --to" << std::endl;
+        return 2;
+    }
+
+    // Для снимка нужен только последний кадр, но позиции сглаживаются по
+    // всей истории, поэтому проигрываем её целиком в обоих режимах
+    RssiStore store(options.history, RssiStoreMode::ReadOnly);
+    if (!options.graph.empty()) {
+        return run_graph(options, store);
+    }
+
+    ScanFilter filter;
+    std::wstring filterError;
+    // Выражения ASCII, кроме строк SSID, а SSID в истории нет
+    if (!filter.compile(std::wstring(options.filter.begin(), options.filter.end()), filterError)) {
+        std::wcerr << L"Invalid --filter: " << filterError << std::endl;
+        return 2;
+    }
+
+    std::vector<Track> tracks;
+    for (const auto& aggregate : store.aggregate(options.from - STALE_AFTER_MS, options.to)) {
+        Track track;
+        track.bssid = aggregate.Bssid;
+        track.label = format_bssid(aggregate.Bssid);
+        track.samples = store.query(aggregate.Bssid, options.from - STALE_AFTER_MS, options.to);
+        if (!track.samples.empty()) {
+            tracks.push_back(std::move(track));
+        }
+    }
+    if (tracks.empty()) {
+        std::cerr << "No RSSI history in " << options.history << " for the requested range" << std::endl;
+        return 1;
+    }
+
+#ifdef _WIN32
+    if (options.raw) {
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+#endif
+
+    std::map<uint64_t, std::pair<double, double>> savedCoordinates;
+    std::map<uint64_t, std::pair<double, double>> previousCoordinates;
+    std::mt19937 gen(static_cast<unsigned>(options.from));
+    RadarStyle style;
+    style.Labels = options.labels;
+    Framebuffer frame(options.width, options.height);
+    std::vector<RadarPoint> points;
+    ScanBatch batch;
+    std::vector<uint8_t> mask;
+    double sonarAngle = 0.0;
+    int64_t nextScan = options.from;
+
+    for (int64_t t = options.from; t <= options.to; t += FRAME_INTERVAL_MS) {
+        if (t >= nextScan) {
+            points.clear();
+            batch.clear();
+            for (auto& track : tracks) {
+                while (track.cursor + 1 < track.samples.size() && track.samples[track.cursor + 1].Timestamp <= t) {
+                    ++track.cursor;
+                }
+                const RssiSample& sample = track.samples[track.cursor];
+                if (sample.Timestamp > t || t - sample.Timestamp > STALE_AFTER_MS) {
+                    continue;
+                }
+                double distance = calculate_distance(sample.Rssi, 2.4);
+                std::pair<double, double> point = place_point(track.bssid, distance, savedCoordinates, gen);
+                point = smooth_point(track.bssid, point, previousCoordinates, SMOOTHING_ALPHA);
+                points.push_back({ point.first, point.second, track.label });
+                batch.add(std::wstring(), sample.Rssi, 0);
+            }
+            // Позиции сглаживаются для всех точек, чтобы фильтр не сдвигал оставшиеся
+            if (!filter.empty()) {
+                filter.run(batch, mask);
+                size_t kept = 0;
+                for (size_t i = 0; i < points.size(); ++i) {
+                    if (mask[i]) {
+                        if (kept != i) {
+                            points[kept] = std::move(points[i]);
+                        }
+                        ++kept;
+                    }
+                }
+                points.resize(kept);
+            }
+            nextScan = t + SCAN_INTERVAL_MS;
+        }
+
+        bool lastFrame = t + FRAME_INTERVAL_MS > options.to;
+        if (options.raw || lastFrame) {
+            render_radar(frame, points, options.scale, sonarAngle, style);
+        }
+        if (options.raw && !write_raw_frame(frame, stdout)) {
+            std::cerr << "Failed to write frame, output closed" << std::endl;
+            return 1;
+        }
+
+        sonarAngle += 0.1;
+        if (sonarAngle >= 2 * M_PI) {
+            sonarAngle = 0.0;
+        }
+    }
+
+    if (!options.png.empty() && !write_png(frame, options.png)) {
+        std::cerr << "Failed to write " << options.png << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,600 @@
+// Программный рендер радара и графиков сигнала в RGBA-буфер в памяти.
+//
+// Не зависит от GDI+ и работает на любой платформе: заливка горизонтальных
+// отрезков идёт через SSE2 по 4 пикселя, линии и окружности сглажены
+// (алгоритм Ву), подписи рисуются встроенным растровым шрифтом 5x7.
+// Кадр сохраняется в PNG или пишется сырым потоком RGBA для кодирования
+// в видео, например:
+//   radar-render --raw | ffmpeg -f rawvideo -pixel_format rgba -video_size 1920x1080 -i - radar.mp4
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define RADAR_RASTER_SSE2
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Цвет упакован так, что в памяти байты идут в порядке R, G, B, A
+inline uint32_t rgba(uint32_t r, uint32_t g, uint32_t b, uint32_t a = 255) {
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+// Смешивание с покрытием alpha (0..255), результат всегда непрозрачный
+inline uint32_t blend_pixel(uint32_t dst, uint32_t src, uint32_t alpha) {
+    uint32_t a = alpha + (alpha >> 7); // 0..256
+    uint32_t rb = ((src & 0x00FF00FF) * a + (dst & 0x00FF00FF) * (256 - a)) >> 8;
+    uint32_t g = (((src >> 8) & 0xFF) * a + ((dst >> 8) & 0xFF) * (256 - a)) >> 8;
+    return (rb & 0x00FF00FF) | ((g & 0xFF) << 8) | 0xFF000000;
+}
+
+// Шрифт 5x7 для ASCII 0x20..0x7E: 5 столбцов, младший бит - верхняя строка
+static const uint8_t RASTER_FONT[95][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+    {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+    {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08},
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+    {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31},
+    {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+    {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+    {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+    {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01}, {0x3E,0x41,0x49,0x49,0x7A},
+    {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+    {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x0C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+    {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F},
+    {0x63,0x14,0x08,0x14,0x63}, {0x07,0x08,0x70,0x08,0x07}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00},
+    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+    {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20},
+    {0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x0C,0x52,0x52,0x52,0x3E},
+    {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00}, {0x7F,0x10,0x28,0x44,0x00},
+    {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+    {0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
+    {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C},
+    {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00},
+    {0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x08,0x04,0x08,0x10,0x08},
+};
+
+// Кириллическая "Я" для подписи центра радара, как в wifi-checker
+static const uint8_t RASTER_GLYPH_YA[5] = {0x46,0x29,0x19,0x09,0x7F};
+
+class Framebuffer {
+public:
+    Framebuffer(int width, int height) : width_(width), height_(height), pixels_(static_cast<size_t>(width) * height) {}
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    uint32_t* data() { return pixels_.data(); }
+    const uint32_t* data() const { return pixels_.data(); }
+    uint32_t pixel(int x, int y) const { return pixels_[static_cast<size_t>(y) * width_ + x]; }
+
+    void clear(uint32_t color) {
+        for (int y = 0; y < height_; ++y) {
+            fill_span(y, 0, width_, color);
+        }
+    }
+
+    // Непрозрачная заливка пикселей [x0, x1) строки y
+    void fill_span(int y, int x0, int x1, uint32_t color) {
+        if (y < 0 || y >= height_) {
+            return;
+        }
+        x0 = (std::max)(x0, 0);
+        x1 = (std::min)(x1, width_);
+        uint32_t* row = pixels_.data() + static_cast<size_t>(y) * width_;
+        int x = x0;
+#ifdef RADAR_RASTER_SSE2
+        const __m128i value = _mm_set1_epi32(static_cast<int>(color | 0xFF000000));
+        for (; x + 4 <= x1; x += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), value);
+        }
+#endif
+        for (; x < x1; ++x) {
+            row[x] = color | 0xFF000000;
+        }
+    }
+
+    // Полупрозрачная заливка пикселей [x0, x1) строки y с покрытием alpha
+    void blend_span(int y, int x0, int x1, uint32_t color, uint32_t alpha) {
+        if (alpha >= 255) {
+            fill_span(y, x0, x1, color);
+            return;
+        }
+        if (y < 0 || y >= height_ || alpha == 0) {
+            return;
+        }
+        x0 = (std::max)(x0, 0);
+        x1 = (std::min)(x1, width_);
+        uint32_t* row = pixels_.data() + static_cast<size_t>(y) * width_;
+        int x = x0;
+#ifdef RADAR_RASTER_SSE2
+        const uint32_t a = alpha + (alpha >> 7);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i source = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), zero), _mm_set1_epi16(static_cast<short>(a)));
+        const __m128i inverse = _mm_set1_epi16(static_cast<short>(256 - a));
+        const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        for (; x + 4 <= x1; x += 4) {
+            __m128i dst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            __m128i low = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), inverse), source), 8);
+            __m128i high = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), inverse), source), 8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), _mm_or_si128(_mm_packus_epi16(low, high), opaque));
+        }
+#endif
+        for (; x < x1; ++x) {
+            row[x] = blend_pixel(row[x], color, alpha);
+        }
+    }
+
+    void plot(int x, int y, uint32_t color, double coverage) {
+        if (x < 0 || y < 0 || x >= width_ || y >= height_ || coverage <= 0) {
+            return;
+        }
+        uint32_t& dst = pixels_[static_cast<size_t>(y) * width_ + x];
+        uint32_t alpha = static_cast<uint32_t>((std::min)(coverage, 1.0) * (color >> 24));
+        dst = blend_pixel(dst, color, alpha);
+    }
+
+    // Сглаженная линия толщиной в 1 пиксель (алгоритм Ву)
+    void draw_line(double x0, double y0, double x1, double y1, uint32_t color) {
+        bool steep = std::fabs(y1 - y0) > std::fabs(x1 - x0);
+        if (steep) {
+            std::swap(x0, y0);
+            std::swap(x1, y1);
+        }
+        if (x0 > x1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+
+        double dx = x1 - x0;
+        double gradient = dx == 0 ? 1.0 : (y1 - y0) / dx;
+        int xStart = static_cast<int>(std::floor(x0 + 0.5));
+        int xEnd = static_cast<int>(std::floor(x1 + 0.5));
+        // Отсекаем невидимую часть, чтобы длинные линии за кадром ничего не стоили
+        int limit = steep ? height_ : width_;
+        int from = (std::max)(xStart, 0);
+        int to = (std::min)(xEnd, limit - 1);
+        double y = y0 + gradient * (from - x0);
+        for (int x = from; x <= to; ++x, y += gradient) {
+            int iy = static_cast<int>(std::floor(y));
+            double frac = y - iy;
+            if (steep) {
+                plot(iy, x, color, 1 - frac);
+                plot(iy + 1, x, color, frac);
+            } else {
+                plot(x, iy, color, 1 - frac);
+                plot(x, iy + 1, color, frac);
+            }
+        }
+    }
+
+    // Сглаженная окружность толщиной в 1 пиксель
+    void draw_circle(double cx, double cy, double radius, uint32_t color) {
+        if (radius <= 0) {
+            return;
+        }
+        int steps = static_cast<int>(std::ceil(radius / std::sqrt(2.0)));
+        for (int i = 0; i <= steps; ++i) {
+            double y = std::sqrt((std::max)(radius * radius - static_cast<double>(i) * i, 0.0));
+            int iy = static_cast<int>(std::floor(y));
+            double frac = y - iy;
+            for (int octant = 0; octant < 8; ++octant) {
+                // На диагонали i == iy октанты совпадают, рисуем только половину
+                if (i == iy && (octant & 4)) {
+                    continue;
+                }
+                int sx = (octant & 1) ? -1 : 1;
+                int sy = (octant & 2) ? -1 : 1;
+                bool swapAxes = (octant & 4) != 0;
+                for (int k = 0; k < 2; ++k) {
+                    int a = i * sx;
+                    int b = (iy + k) * sy;
+                    double coverage = k == 0 ? 1 - frac : frac;
+                    int px = swapAxes ? b : a;
+                    int py = swapAxes ? a : b;
+                    plot(static_cast<int>(std::floor(cx)) + px, static_cast<int>(std::floor(cy)) + py, color, coverage);
+                }
+            }
+        }
+    }
+
+    // Сглаженный залитый круг: внутренние пиксели строки заливаются через fill_span
+    void fill_circle(double cx, double cy, double radius, uint32_t color) {
+        int top = static_cast<int>(std::floor(cy - radius));
+        int bottom = static_cast<int>(std::ceil(cy + radius));
+        for (int y = top; y <= bottom; ++y) {
+            double dy = y + 0.5 - cy;
+            double w2 = radius * radius - dy * dy;
+            if (w2 <= 0) {
+                continue;
+            }
+            double w = std::sqrt(w2);
+            double left = cx - w;
+            double right = cx + w;
+            int innerLeft = static_cast<int>(std::ceil(left));
+            int innerRight = static_cast<int>(std::floor(right));
+            if (innerLeft > innerRight) {
+                plot(static_cast<int>(std::floor(left)), y, color, right - left);
+                continue;
+            }
+            fill_span(y, innerLeft, innerRight, color);
+            plot(innerLeft - 1, y, color, innerLeft - left);
+            plot(innerRight, y, color, right - innerRight);
+        }
+    }
+
+    // Текст шрифтом 5x7, масштаб scale. Символы вне ASCII выводятся как "?".
+    // Глифы раскладываются на отрезки один раз для текущего масштаба; подпись,
+    // целиком попавшая в кадр, пишется по готовым смещениям без проверок границ
+    void draw_text(int x, int y, const std::wstring& text, uint32_t color, int scale = 1) {
+        if (text.empty() || scale <= 0 || x >= width_ || y >= height_ || y + 7 * scale <= 0) {
+            return;
+        }
+        int textWidth = static_cast<int>(text.size() * 6 - 1) * scale;
+        if (x + textWidth <= 0) {
+            return;
+        }
+        if (scale != glyphScale_) {
+            build_glyph_runs(scale);
+        }
+        color |= 0xFF000000;
+        bool inside = x >= 0 && y >= 0 && x + textWidth <= width_ && y + 7 * scale <= height_;
+        uint32_t* origin = inside ? pixels_.data() + static_cast<size_t>(y) * width_ + x : nullptr;
+        for (size_t index = 0; index < text.size(); ++index) {
+            size_t glyph = glyph_index(text[index]);
+            const GlyphRun* run = glyphRuns_.data() + glyphStart_[glyph];
+            const GlyphRun* end = glyphRuns_.data() + glyphStart_[glyph + 1];
+            int left = static_cast<int>(index) * 6 * scale;
+            if (inside) {
+                for (uint32_t* target = origin + left; run != end; ++run) {
+                    fill_short(target + run->Offset, run->Length, color);
+                }
+            } else {
+                for (; run != end; ++run) {
+                    fill_span(y + run->Row, x + left + run->Column, x + left + run->Column + run->Length, color);
+                }
+            }
+        }
+    }
+
+private:
+    // Закрашенный отрезок глифа: строка и столбец от левого верхнего угла
+    // и то же смещение в пикселях буфера (Row * width_ + Column)
+    struct GlyphRun {
+        int Row;
+        int Column;
+        int Length;
+        int Offset;
+    };
+
+    // Короткие отрезки глифов (1..5 * scale пикселей) пишутся перекрывающимися
+    // записями по 4 и 2 пикселя вместо цикла по одному
+    static void fill_short(uint32_t* target, int length, uint32_t color) {
+#ifdef RADAR_RASTER_SSE2
+        if (length >= 4) {
+            const __m128i value = _mm_set1_epi32(static_cast<int>(color));
+            int x = 0;
+            for (; x + 4 < length; x += 4) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(target + x), value);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(target + length - 4), value);
+            return;
+        }
+#endif
+        if (length >= 2) {
+            uint64_t pair = color | (static_cast<uint64_t>(color) << 32);
+            std::memcpy(target, &pair, sizeof(pair));
+            std::memcpy(target + length - 2, &pair, sizeof(pair));
+        } else if (length == 1) {
+            target[0] = color;
+        }
+    }
+
+    // 0..94 - ASCII 0x20..0x7E, 95 - "Я"
+    static size_t glyph_index(wchar_t ch) {
+        if (ch == L'Я') {
+            return 95;
+        }
+        return ch >= 0x20 && ch <= 0x7E ? static_cast<size_t>(ch - 0x20) : static_cast<size_t>('?' - 0x20);
+    }
+
+    void build_glyph_runs(int scale) {
+        glyphRuns_.clear();
+        for (size_t glyph = 0; glyph < 96; ++glyph) {
+            glyphStart_[glyph] = glyphRuns_.size();
+            const uint8_t* columns = glyph == 95 ? RASTER_GLYPH_YA : RASTER_FONT[glyph];
+            // Соседние закрашенные столбцы строки глифа сливаются в один отрезок
+            for (int row = 0; row < 7; ++row) {
+                int column = 0;
+                while (column < 5) {
+                    if ((columns[column] & (1 << row)) == 0) {
+                        ++column;
+                        continue;
+                    }
+                    int end = column + 1;
+                    while (end < 5 && (columns[end] & (1 << row))) {
+                        ++end;
+                    }
+                    for (int sy = 0; sy < scale; ++sy) {
+                        int runRow = row * scale + sy;
+                        glyphRuns_.push_back({ runRow, column * scale, (end - column) * scale, runRow * width_ + column * scale });
+                    }
+                    column = end;
+                }
+            }
+        }
+        glyphStart_[96] = glyphRuns_.size();
+        glyphScale_ = scale;
+    }
+
+    int width_;
+    int height_;
+    std::vector<uint32_t> pixels_;
+    std::vector<GlyphRun> glyphRuns_;
+    size_t glyphStart_[97] = {};
+    int glyphScale_ = 0;
+};
+
+struct RadarPoint {
+    double X; // Coordinates in meters, same as Network::X/Y in wifi-checker
+    double Y;
+    std::wstring Label;
+};
+
+struct RadarStyle {
+    uint32_t Background = rgba(50, 50, 50);
+    uint32_t Grid = rgba(0, 255, 0);
+    uint32_t Point = rgba(255, 0, 0);
+    int TextScale = 2;
+    bool Labels = true;
+};
+
+// Рисует радар так же, как plot_radar в wifi-checker: сетка, сонар, точки и подписи
+inline void render_radar(Framebuffer& frame, const std::vector<RadarPoint>& points, double scale, double sonarAngle, const RadarStyle& style = RadarStyle()) {
+    frame.clear(style.Background);
+
+    int centerX = frame.width() / 2;
+    int centerY = frame.height() / 2;
+    double radius = ((std::min)(centerX, centerY) - 10) * scale;
+
+    for (int i = 1; i <= 5; ++i) {
+        frame.draw_circle(centerX, centerY, i * radius / 5, style.Grid);
+    }
+    for (int i = 0; i < 360; i += 30) {
+        double angle = i * M_PI / 180;
+        frame.draw_line(centerX, centerY, centerX + radius * std::cos(angle), centerY + radius * std::sin(angle), style.Grid);
+    }
+
+    frame.fill_circle(centerX, centerY, 5, style.Point);
+    frame.draw_text(centerX + 10, centerY, L"Я", style.Point, style.TextScale);
+
+    // Сонар толщиной 2 пикселя
+    double sonarX = centerX + radius * std::cos(sonarAngle);
+    double sonarY = centerY + radius * std::sin(sonarAngle);
+    bool steep = std::fabs(std::sin(sonarAngle)) > std::fabs(std::cos(sonarAngle));
+    frame.draw_line(centerX, centerY, sonarX, sonarY, style.Grid);
+    frame.draw_line(centerX + (steep ? 1 : 0), centerY + (steep ? 0 : 1), sonarX + (steep ? 1 : 0), sonarY + (steep ? 0 : 1), style.Grid);
+
+    // Экранные координаты точек; соседей ищем через сетку ячеек 20x20,
+    // чтобы не сравнивать каждую пару точек
+    const int cell = 20;
+    std::vector<int> screenX(points.size()), screenY(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        screenX[i] = static_cast<int>(centerX + points[i].X / 100 * radius);
+        screenY[i] = static_cast<int>(centerY + points[i].Y / 100 * radius);
+    }
+
+    std::vector<int> labelOffset(points.size(), 0);
+    if (style.Labels && !points.empty()) {
+        int gridWidth = frame.width() / cell + 3;
+        int gridHeight = frame.height() / cell + 3;
+        // Деление с округлением вниз: иначе -19..19 попадают в одну ячейку.
+        // Точки за краем кадра прижимаются к крайним ячейкам
+        auto cellCoordinate = [&](int value, int limit) {
+            int index = (value < 0 ? value - (cell - 1) : value) / cell + 1;
+            return (std::min)((std::max)(index, 0), limit - 1);
+        };
+        // Точки раскладываются по ячейкам подсчётом: cellPoints[cellStart[c]..cellStart[c + 1])
+        // - точки ячейки c. Два массива вместо вектора на каждую ячейку в каждом кадре
+        std::vector<int> pointCell(points.size());
+        std::vector<int> cellStart(static_cast<size_t>(gridWidth) * gridHeight + 1, 0);
+        for (size_t i = 0; i < points.size(); ++i) {
+            pointCell[i] = cellCoordinate(screenY[i], gridHeight) * gridWidth + cellCoordinate(screenX[i], gridWidth);
+            ++cellStart[pointCell[i] + 1];
+        }
+        for (size_t c = 1; c < cellStart.size(); ++c) {
+            cellStart[c] += cellStart[c - 1];
+        }
+        std::vector<int> cellPoints(points.size());
+        std::vector<int> cellFill(cellStart.begin(), cellStart.end() - 1);
+        for (size_t i = 0; i < points.size(); ++i) {
+            cellPoints[cellFill[pointCell[i]]++] = static_cast<int>(i);
+        }
+        // Как в plot_radar: подпись смещается вниз на 20 пикселей за каждого близкого соседа
+        for (size_t i = 0; i < points.size(); ++i) {
+            // Соседние ячейки по каждой оси без повторов: у края кадра прижатые
+            // индексы совпадают, и одну ячейку нельзя обходить дважды
+            int columns[3], rows[3];
+            int columnCount = 0, rowCount = 0;
+            for (int d = -cell; d <= cell; d += cell) {
+                int gx = cellCoordinate(screenX[i] + d, gridWidth);
+                if (columnCount == 0 || columns[columnCount - 1] != gx) {
+                    columns[columnCount++] = gx;
+                }
+                int gy = cellCoordinate(screenY[i] + d, gridHeight);
+                if (rowCount == 0 || rows[rowCount - 1] != gy) {
+                    rows[rowCount++] = gy;
+                }
+            }
+            for (int r = 0; r < rowCount; ++r) {
+                for (int c = 0; c < columnCount; ++c) {
+                    int index = rows[r] * gridWidth + columns[c];
+                    for (int k = cellStart[index]; k < cellStart[index + 1]; ++k) {
+                        int j = cellPoints[k];
+                        if (static_cast<size_t>(j) != i && std::abs(screenX[i] - screenX[j]) < cell && std::abs(screenY[i] - screenY[j]) < cell) {
+                            labelOffset[i] += 20;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        int x = screenX[i];
+        int y = screenY[i];
+        if (x < -cell || y < -cell || x >= frame.width() + cell || y >= frame.height() + cell) {
+            continue;
+        }
+        frame.draw_circle(x, y + labelOffset[i], 2, style.Point);
+        if (style.Labels) {
+            frame.draw_text(x, y + labelOffset[i], points[i].Label, style.Point, style.TextScale);
+        }
+    }
+}
+
+// Рисует график сигнала так же, как DrawGraph в checkpower
+inline void render_graph(Framebuffer& frame, const std::vector<int>& data, uint32_t background = rgba(255, 255, 255)) {
+    frame.clear(background);
+    int width = frame.width();
+    int height = frame.height();
+
+    for (int i = 0; i <= 10; ++i) {
+        int y = i * height / 10;
+        frame.fill_span((std::min)(y, height - 1), 0, width, rgba(200, 200, 200));
+    }
+    if (data.size() < 2) {
+        return;
+    }
+
+    int maxValue = *std::max_element(data.begin(), data.end());
+    int minValue = *std::min_element(data.begin(), data.end());
+    auto scaleY = [&](int value) {
+        return maxValue == minValue ? static_cast<double>(height) : height - static_cast<double>(value - minValue) * height / (maxValue - minValue);
+    };
+    for (size_t i = 1; i < data.size(); ++i) {
+        double x1 = static_cast<double>(i - 1) * width / data.size();
+        double x2 = static_cast<double>(i) * width / data.size();
+        frame.draw_line(x1, scaleY(data[i - 1]), x2, scaleY(data[i]), rgba(0, 255, 0));
+    }
+}
+
+inline uint32_t png_crc(const uint8_t* data, size_t size, uint32_t crc = 0xFFFFFFFFu) {
+    // Локальный static инициализируется потокобезопасно, write_png можно звать из разных потоков
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> result = {};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            result[n] = c;
+        }
+        return result;
+    }();
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+inline void png_put32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline void png_chunk(std::FILE* file, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> header;
+    png_put32(header, static_cast<uint32_t>(data.size()));
+    header.insert(header.end(), type, type + 4);
+    uint32_t crc = png_crc(header.data() + 4, 4);
+    crc = png_crc(data.data(), data.size(), crc) ^ 0xFFFFFFFFu;
+    std::vector<uint8_t> footer;
+    png_put32(footer, crc);
+    std::fwrite(header.data(), 1, header.size(), file);
+    std::fwrite(data.data(), 1, data.size(), file);
+    std::fwrite(footer.data(), 1, footer.size(), file);
+}
+
+// Сохраняет кадр в PNG. Без zlib данные пишутся несжатыми блоками deflate,
+// такой файл читает любой просмотрщик.
+inline bool write_png(const Framebuffer& frame, const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::fwrite(signature, 1, sizeof(signature), file);
+
+    std::vector<uint8_t> header;
+    png_put32(header, static_cast<uint32_t>(frame.width()));
+    png_put32(header, static_cast<uint32_t>(frame.height()));
+    header.push_back(8); // Bit depth
+    header.push_back(6); // RGBA
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    png_chunk(file, "IHDR", header);
+
+    // Поток zlib: строки с фильтром 0, нарезанные на stored-блоки до 65535 байт
+    size_t rowBytes = static_cast<size_t>(frame.width()) * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowBytes + 1) * frame.height());
+    for (int y = 0; y < frame.height(); ++y) {
+        raw.push_back(0);
+        const uint8_t* row = reinterpret_cast<const uint8_t*>(frame.data() + static_cast<size_t>(y) * frame.width());
+        raw.insert(raw.end(), row, row + rowBytes);
+    }
+
+    std::vector<uint8_t> zlib;
+    zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    uint32_t adlerA = 1, adlerB = 0;
+    for (size_t offset = 0; offset < raw.size() || offset == 0; ) {
+        size_t length = (std::min)(raw.size() - offset, static_cast<size_t>(65535));
+        bool last = offset + length == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(length));
+        zlib.push_back(static_cast<uint8_t>(length >> 8));
+        zlib.push_back(static_cast<uint8_t>(~length));
+        zlib.push_back(static_cast<uint8_t>(~length >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+        for (size_t i = offset; i < offset + length; ++i) {
+            adlerA = (adlerA + raw[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+        offset += length;
+        if (last) {
+            break;
+        }
+    }
+    png_put32(zlib, (adlerB << 16) | adlerA);
+    png_chunk(file, "IDAT", zlib);
+    png_chunk(file, "IEND", std::vector<uint8_t>());
+
+    bool ok = std::ferror(file) == 0;
+    return std::fclose(file) == 0 && ok;
+}
+
+// Пишет кадр сырыми байтами RGBA (для ffmpeg -f rawvideo -pixel_format rgba)
+inline bool write_raw_frame(const Framebuffer& frame, std::FILE* file) {
+    size_t count = static_cast<size_t>(frame.width()) * frame.height();
+    return std::fwrite(frame.data(), sizeof(uint32_t), count, file) == count;
+}
@@ -0,0 +1,155 @@
+// Нагрузочный тест хранилища истории RSSI (rssi_store.h): скорость записи,
+// задержка запроса одного BSSID и агрегата по всем точкам доступа.
+//
+//   rssi-bench [--dir DIR] [--aps N] [--hours H] [--keep]
+//
+// Сэмплы генерируются так, как их пишет checkpower: каждые 2 секунды по
+// одному замеру на каждую точку доступа. Каталог по умолчанию - временный,
+// после теста он удаляется, если не указан --keep.
+//
+// Сборка: g++ -O2 -std=c++17 rssi-bench.cpp -o rssi-bench -pthread
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rssi_store.h"
+
+const int64_t SCAN_INTERVAL_MS = 2000; // Как таймер сканирования в checkpower
+const int64_t HOUR_MS = 60 * 60 * 1000;
+const int QUERY_ROUNDS = 200;
+
+struct Options {
+    std::filesystem::path directory;
+    int aps = 100;
+    int hours = 24 * 7;
+    bool keep = false;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--dir" && hasValue) {
+            options.directory = argv[++i];
+        } else if (arg == "--aps" && hasValue) {
+            options.aps = std::atoi(argv[++i]);
+        } else if (arg == "--hours" && hasValue) {
+            options.hours = std::atoi(argv[++i]);
+        } else if (arg == "--keep") {
+            options.keep = true;
+        } else {
+            return false;
+        }
+    }
+    return options.aps > 0 && options.hours > 0;
+}
+
+double elapsed_seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+uint64_t directory_bytes(const std::filesystem::path& directory) {
+    uint64_t total = 0;
+    std::error_code error;
+    for (const auto& item : std::filesystem::directory_iterator(directory, error)) {
+        if (item.path().extension() == ".seg") {
+            total += item.file_size(error);
+        }
+    }
+    return total;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::cerr << "Usage: rssi-bench [--dir DIR] [--aps N] [--hours H] [--keep]" << std::endl;
+        return 2;
+    }
+    bool temporary = options.directory.empty();
+    if (temporary) {
+        options.directory = std::filesystem::temp_directory_path() / ("rssi-bench-" + std::to_string(std::random_device()()));
+    }
+
+    const int64_t start = 1700000000000; // Фиксированное начало, чтобы прогоны были сравнимы
+    const int64_t end = start + options.hours * HOUR_MS;
+    std::mt19937 gen(42);
+    std::normal_distribution<> noise(0, 3);
+    std::vector<uint64_t> bssids(options.aps);
+    std::vector<int> baseRssi(options.aps);
+    for (int i = 0; i < options.aps; ++i) {
+        bssids[i] = 0x020000000000ull | static_cast<uint64_t>(gen() & 0xFFFFFFFF);
+        baseRssi[i] = -40 - static_cast<int>(gen() % 50);
+    }
+
+    {
+        RssiStore store(options.directory);
+
+        // Запись
+        uint64_t samples = 0;
+        auto ingestStart = std::chrono::steady_clock::now();
+        for (int64_t t = start; t < end; t += SCAN_INTERVAL_MS) {
+            for (int i = 0; i < options.aps; ++i) {
+                store.append(bssids[i], t + static_cast<int64_t>(gen() % 200), baseRssi[i] + static_cast<int>(noise(gen)));
+            }
+            samples += options.aps;
+        }
+        if (!store.flush()) {
+            std::cerr << "Failed to flush " << options.directory << std::endl;
+            return 1;
+        }
+        double ingestSeconds = elapsed_seconds(ingestStart);
+        std::printf("ingest: %llu samples in %.2f s, %.2f M samples/s\n",
+                    static_cast<unsigned long long>(samples), ingestSeconds, samples / ingestSeconds / 1e6);
+
+        // Запросы одного BSSID: последний час и вся история
+        auto queryStart = std::chrono::steady_clock::now();
+        size_t returned = 0;
+        for (int round = 0; round < QUERY_ROUNDS; ++round) {
+            returned += store.query(bssids[round % options.aps], end - HOUR_MS, end).size();
+        }
+        std::printf("query one BSSID, last hour: %.3f ms (%zu samples)\n",
+                    elapsed_seconds(queryStart) * 1000 / QUERY_ROUNDS, returned / QUERY_ROUNDS);
+
+        queryStart = std::chrono::steady_clock::now();
+        returned = 0;
+        for (int round = 0; round < QUERY_ROUNDS / 10; ++round) {
+            returned += store.query(bssids[round % options.aps], start, end).size();
+        }
+        std::printf("query one BSSID, full history: %.3f ms (%zu samples)\n",
+                    elapsed_seconds(queryStart) * 1000 / (QUERY_ROUNDS / 10), returned / (QUERY_ROUNDS / 10));
+
+        // Агрегаты по всем точкам доступа
+        auto aggregateStart = std::chrono::steady_clock::now();
+        size_t groups = 0;
+        for (int round = 0; round < QUERY_ROUNDS / 10; ++round) {
+            groups += store.aggregate(end - HOUR_MS, end).size();
+        }
+        std::printf("aggregate all APs, last hour: %.3f ms (%zu APs)\n",
+                    elapsed_seconds(aggregateStart) * 1000 / (QUERY_ROUNDS / 10), groups / (QUERY_ROUNDS / 10));
+
+        aggregateStart = std::chrono::steady_clock::now();
+        groups = 0;
+        for (int round = 0; round < QUERY_ROUNDS / 10; ++round) {
+            groups += store.aggregate(start, end).size();
+        }
+        std::printf("aggregate all APs, full history: %.3f ms (%zu APs)\n",
+                    elapsed_seconds(aggregateStart) * 1000 / (QUERY_ROUNDS / 10), groups / (QUERY_ROUNDS / 10));
+
+        uint64_t bytes = directory_bytes(options.directory);
+        std::printf("storage: %zu segments, %.1f MB, %.2f bytes/sample\n",
+                    store.segment_count(), bytes / 1e6, static_cast<double>(bytes) / samples);
+    }
+
+    if (temporary && !options.keep) {
+        std::error_code error;
+        std::filesystem::remove_all(options.directory, error);
+    } else {
+        std::printf("data kept in %s\n", options.directory.string().c_str());
+    }
+    return 0;
+}
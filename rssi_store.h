@@ -0,0 +1,688 @@
+// Встраиваемое хранилище истории RSSI.
+//
+// Данные пишутся только добавлением: сэмплы копятся в памяти и сбрасываются
+// в неизменяемые сегменты rssi-<firstSeq>-<lastSeq>.seg. Внутри сегмента у
+// каждого BSSID по блоку на каждый час (RSSI_BLOCK_WINDOW_MS) из двух колонок:
+// метки времени (delta-of-delta + zig-zag + varint) и RSSI (delta + zig-zag + varint).
+// В конце сегмента лежит индекс, отсортированный по BSSID и времени, с
+// диапазоном времени и агрегатами каждого блока, поэтому запросы читают только
+// нужные блоки, а агрегаты по полностью попавшим в диапазон блокам берутся
+// прямо из индекса. Фоновый поток сливает соседние сегменты близкого размера
+// (size-tiered): каждый сэмпл переписывается O(log) раз, а сегменты больше
+// RSSI_MAX_COMPACTION_BYTES больше не переписываются.
+//
+// Формат сегмента (little-endian):
+//   SegmentHeader
+//   блоки колонок
+//   IndexEntry[entryCount]
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+const uint32_t RSSI_SEGMENT_MAGIC = 0x47455352; // "RSEG"
+const uint32_t RSSI_SEGMENT_VERSION = 2; // 2: выровненные заголовок и индекс
+const size_t RSSI_FLUSH_THRESHOLD = 1 << 20; // Сэмплов в памяти до автоматического сброса
+const size_t RSSI_COMPACTION_FANIN = 4; // Соседних сегментов одного яруса в одном слиянии
+const uint64_t RSSI_TIER_BASE_BYTES = 256 * 1024; // Сегменты меньше этого - нулевой ярус
+const uint64_t RSSI_MAX_COMPACTION_BYTES = 64ull * 1024 * 1024; // Крупные сегменты не сливаются
+const int64_t RSSI_BLOCK_WINDOW_MS = 60 * 60 * 1000; // Блок BSSID не пересекает границу часа
+
+struct RssiSample {
+    int64_t Timestamp; // Milliseconds since the Unix epoch
+    int32_t Rssi; // Signal strength in dBm
+};
+
+struct RssiAggregate {
+    uint64_t Bssid = 0;
+    uint64_t Count = 0;
+    int64_t Sum = 0;
+    int32_t Min = (std::numeric_limits<int32_t>::max)();
+    int32_t Max = (std::numeric_limits<int32_t>::min)();
+
+    void add(int32_t rssi) {
+        ++Count;
+        Sum += rssi;
+        Min = (std::min)(Min, rssi);
+        Max = (std::max)(Max, rssi);
+    }
+
+    void merge(const RssiAggregate& other) {
+        Count += other.Count;
+        Sum += other.Sum;
+        Min = (std::min)(Min, other.Min);
+        Max = (std::max)(Max, other.Max);
+    }
+
+    double mean() const {
+        return Count == 0 ? 0.0 : static_cast<double>(Sum) / Count;
+    }
+};
+
+// Структуры лежат на диске как есть, поэтому поля выровнены естественно и
+// размер зафиксирован: упакованные поля нельзя безопасно связывать со ссылками
+struct RssiSegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t firstSeq; // Диапазон исходных сегментов, покрытых этим (после слияния)
+    uint64_t lastSeq;
+    int64_t minTimestamp;
+    int64_t maxTimestamp;
+    uint64_t indexOffset;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+static_assert(sizeof(RssiSegmentHeader) == 56, "RssiSegmentHeader is an on-disk format");
+
+struct RssiIndexEntry {
+    uint64_t bssid;
+    int64_t minTimestamp;
+    int64_t maxTimestamp;
+    uint64_t offset; // Смещение блока от начала файла
+    int64_t sum;
+    uint32_t timestampBytes;
+    uint32_t rssiBytes;
+    uint32_t count;
+    int32_t minRssi;
+    int32_t maxRssi;
+    uint32_t reserved;
+};
+static_assert(sizeof(RssiIndexEntry) == 64, "RssiIndexEntry is an on-disk format");
+
+inline uint64_t zigzag_encode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzag_decode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline void put_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline bool get_varint(const uint8_t*& cursor, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && cursor < end; shift += 7) {
+        uint8_t byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Кодирует отсортированные по времени сэмплы одного BSSID в блок колонок
+inline RssiIndexEntry encode_block(uint64_t bssid, const std::vector<RssiSample>& samples, std::vector<uint8_t>& out) {
+    RssiIndexEntry entry = {};
+    entry.bssid = bssid;
+    entry.offset = out.size();
+    entry.count = static_cast<uint32_t>(samples.size());
+    entry.minTimestamp = samples.front().Timestamp;
+    entry.maxTimestamp = samples.back().Timestamp;
+    entry.minRssi = (std::numeric_limits<int32_t>::max)();
+    entry.maxRssi = (std::numeric_limits<int32_t>::min)();
+
+    int64_t previous = entry.minTimestamp;
+    int64_t previousDelta = 0;
+    for (const auto& sample : samples) {
+        int64_t delta = sample.Timestamp - previous;
+        put_varint(out, zigzag_encode(delta - previousDelta));
+        previous = sample.Timestamp;
+        previousDelta = delta;
+    }
+    entry.timestampBytes = static_cast<uint32_t>(out.size() - entry.offset);
+
+    int32_t previousRssi = 0;
+    for (const auto& sample : samples) {
+        put_varint(out, zigzag_encode(static_cast<int64_t>(sample.Rssi) - previousRssi));
+        previousRssi = sample.Rssi;
+        entry.sum += sample.Rssi;
+        entry.minRssi = (std::min)(entry.minRssi, sample.Rssi);
+        entry.maxRssi = (std::max)(entry.maxRssi, sample.Rssi);
+    }
+    entry.rssiBytes = static_cast<uint32_t>(out.size() - entry.offset - entry.timestampBytes);
+    return entry;
+}
+
+inline bool decode_block(const RssiIndexEntry& entry, const uint8_t* data, std::vector<RssiSample>& out) {
+    const uint8_t* timestamps = data;
+    const uint8_t* timestampsEnd = data + entry.timestampBytes;
+    const uint8_t* rssi = timestampsEnd;
+    const uint8_t* rssiEnd = rssi + entry.rssiBytes;
+
+    size_t base = out.size();
+    out.resize(base + entry.count);
+    int64_t previous = entry.minTimestamp;
+    int64_t previousDelta = 0;
+    int64_t previousRssi = 0;
+    for (uint32_t i = 0; i < entry.count; ++i) {
+        uint64_t encodedTimestamp, encodedRssi;
+        if (!get_varint(timestamps, timestampsEnd, encodedTimestamp) || !get_varint(rssi, rssiEnd, encodedRssi)) {
+            out.resize(base);
+            return false;
+        }
+        previousDelta += zigzag_decode(encodedTimestamp);
+        previous += previousDelta;
+        previousRssi += zigzag_decode(encodedRssi);
+        out[base + i] = { previous, static_cast<int32_t>(previousRssi) };
+    }
+    return true;
+}
+
+// Открытый сегмент: заголовок и индекс в памяти, блоки читаются с диска по запросу
+class RssiSegment {
+public:
+    static std::shared_ptr<RssiSegment> open(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return nullptr;
+        }
+
+        std::error_code error;
+        uint64_t fileSize = std::filesystem::file_size(path, error);
+        auto segment = std::shared_ptr<RssiSegment>(new RssiSegment(path));
+        RssiSegmentHeader& header = segment->header_;
+        if (error
+            || !file.read(reinterpret_cast<char*>(&header), sizeof(RssiSegmentHeader))
+            || header.magic != RSSI_SEGMENT_MAGIC
+            || header.version != RSSI_SEGMENT_VERSION
+            || header.indexOffset < sizeof(RssiSegmentHeader)
+            || header.indexOffset > fileSize
+            || (fileSize - header.indexOffset) != static_cast<uint64_t>(header.entryCount) * sizeof(RssiIndexEntry)) {
+            return nullptr;
+        }
+
+        segment->index_.resize(segment->header_.entryCount);
+        file.seekg(static_cast<std::streamoff>(segment->header_.indexOffset));
+        if (!file.read(reinterpret_cast<char*>(segment->index_.data()), segment->index_.size() * sizeof(RssiIndexEntry))) {
+            return nullptr;
+        }
+        segment->size_ = fileSize;
+        for (const auto& entry : segment->index_) {
+            // Каждый сэмпл занимает хотя бы байт в обоих потоках, иначе
+            // decode_block выделил бы память под битый count
+            if (entry.count == 0 || entry.count > entry.timestampBytes || entry.count > entry.rssiBytes
+                || entry.offset < sizeof(RssiSegmentHeader)
+                || entry.offset + entry.timestampBytes + entry.rssiBytes > header.indexOffset) {
+                return nullptr;
+            }
+        }
+        return segment;
+    }
+
+    ~RssiSegment() {
+        if (obsolete_) {
+            std::error_code error;
+            std::filesystem::remove(path_, error);
+        }
+    }
+
+    const RssiSegmentHeader& header() const { return header_; }
+    const std::vector<RssiIndexEntry>& index() const { return index_; }
+    const std::filesystem::path& path() const { return path_; }
+    uint64_t size() const { return size_; }
+
+    // Файл удаляется, когда сегмент перестанут использовать все запросы
+    void mark_obsolete() { obsolete_ = true; }
+
+    bool overlaps(int64_t from, int64_t to) const {
+        return header_.entryCount > 0 && header_.minTimestamp <= to && header_.maxTimestamp >= from;
+    }
+
+    // Блоки одного BSSID, отсортированные по времени
+    std::pair<const RssiIndexEntry*, const RssiIndexEntry*> find(uint64_t bssid) const {
+        auto first = std::lower_bound(index_.begin(), index_.end(), bssid,
+                                      [](const RssiIndexEntry& entry, uint64_t key) { return entry.bssid < key; });
+        auto last = std::upper_bound(first, index_.end(), bssid,
+                                     [](uint64_t key, const RssiIndexEntry& entry) { return key < entry.bssid; });
+        return { index_.data() + (first - index_.begin()), index_.data() + (last - index_.begin()) };
+    }
+
+    bool read_block(std::ifstream& file, const RssiIndexEntry& entry, std::vector<uint8_t>& scratch, std::vector<RssiSample>& out) const {
+        scratch.resize(static_cast<size_t>(entry.timestampBytes) + entry.rssiBytes);
+        file.seekg(static_cast<std::streamoff>(entry.offset));
+        if (!file.read(reinterpret_cast<char*>(scratch.data()), scratch.size())) {
+            file.clear();
+            return false;
+        }
+        return decode_block(entry, scratch.data(), out);
+    }
+
+private:
+    explicit RssiSegment(const std::filesystem::path& path) : path_(path) {}
+
+    std::filesystem::path path_;
+    RssiSegmentHeader header_ = {};
+    std::vector<RssiIndexEntry> index_;
+    uint64_t size_ = 0;
+    std::atomic<bool> obsolete_{false};
+};
+
+// ReadOnly открывает историю, которую может писать другой процесс: без фонового
+// слияния и без удаления файлов, append() игнорируется
+enum class RssiStoreMode {
+    ReadWrite,
+    ReadOnly
+};
+
+class RssiStore {
+public:
+    explicit RssiStore(const std::filesystem::path& directory, RssiStoreMode mode = RssiStoreMode::ReadWrite)
+        : directory_(directory), readOnly_(mode == RssiStoreMode::ReadOnly) {
+        std::error_code error;
+        if (!readOnly_) {
+            std::filesystem::create_directories(directory_, error);
+        }
+        load_segments();
+        if (!readOnly_) {
+            worker_ = std::thread(&RssiStore::compaction_loop, this);
+        }
+    }
+
+    ~RssiStore() {
+        if (readOnly_) {
+            return;
+        }
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cancelled_ = true;
+        wakeup_.notify_all();
+        worker_.join();
+    }
+
+    RssiStore(const RssiStore&) = delete;
+    RssiStore& operator=(const RssiStore&) = delete;
+
+    void append(uint64_t bssid, int64_t timestamp, int32_t rssi) {
+        if (readOnly_) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        memtable_[bssid].push_back({ timestamp, rssi });
+        if (++memtableSize_ >= RSSI_FLUSH_THRESHOLD) {
+            flush_locked();
+        }
+    }
+
+    // Сбрасывает накопленные в памяти сэмплы в новый сегмент
+    bool flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return flush_locked();
+    }
+
+    // Сэмплы одного BSSID в диапазоне [from, to], отсортированные по времени
+    std::vector<RssiSample> query(uint64_t bssid, int64_t from, int64_t to) const {
+        std::vector<std::shared_ptr<RssiSegment>> segments;
+        std::vector<RssiSample> result;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            segments = segments_;
+            auto it = memtable_.find(bssid);
+            if (it != memtable_.end()) {
+                for (const auto& sample : it->second) {
+                    if (sample.Timestamp >= from && sample.Timestamp <= to) {
+                        result.push_back(sample);
+                    }
+                }
+            }
+        }
+
+        std::vector<uint8_t> scratch;
+        std::vector<RssiSample> block;
+        for (const auto& segment : segments) {
+            if (!segment->overlaps(from, to)) {
+                continue;
+            }
+            std::ifstream file;
+            auto range = segment->find(bssid);
+            for (const RssiIndexEntry* entry = range.first; entry != range.second; ++entry) {
+                if (entry->minTimestamp > to || entry->maxTimestamp < from) {
+                    continue;
+                }
+                if (!file.is_open()) {
+                    file.open(segment->path(), std::ios::binary);
+                }
+                block.clear();
+                if (!file || !segment->read_block(file, *entry, scratch, block)) {
+                    continue;
+                }
+                for (const auto& sample : block) {
+                    if (sample.Timestamp >= from && sample.Timestamp <= to) {
+                        result.push_back(sample);
+                    }
+                }
+            }
+        }
+
+        std::stable_sort(result.begin(), result.end(),
+                         [](const RssiSample& a, const RssiSample& b) { return a.Timestamp < b.Timestamp; });
+        return result;
+    }
+
+    // Агрегаты по всем BSSID в диапазоне [from, to]. Блоки, целиком попавшие в
+    // диапазон, не декодируются: их агрегаты берутся из индекса сегмента.
+    std::vector<RssiAggregate> aggregate(int64_t from, int64_t to) const {
+        std::vector<std::shared_ptr<RssiSegment>> segments;
+        std::map<uint64_t, RssiAggregate> totals;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            segments = segments_;
+            for (const auto& entry : memtable_) {
+                for (const auto& sample : entry.second) {
+                    if (sample.Timestamp >= from && sample.Timestamp <= to) {
+                        totals[entry.first].add(sample.Rssi);
+                    }
+                }
+            }
+        }
+
+        std::vector<uint8_t> scratch;
+        std::vector<RssiSample> block;
+        for (const auto& segment : segments) {
+            if (!segment->overlaps(from, to)) {
+                continue;
+            }
+            std::ifstream file;
+            for (const auto& entry : segment->index()) {
+                if (entry.minTimestamp > to || entry.maxTimestamp < from) {
+                    continue;
+                }
+                RssiAggregate& total = totals[entry.bssid];
+                if (entry.minTimestamp >= from && entry.maxTimestamp <= to) {
+                    total.Count += entry.count;
+                    total.Sum += entry.sum;
+                    total.Min = (std::min)(total.Min, entry.minRssi);
+                    total.Max = (std::max)(total.Max, entry.maxRssi);
+                    continue;
+                }
+                if (!file.is_open()) {
+                    file.open(segment->path(), std::ios::binary);
+                }
+                block.clear();
+                if (!file || !segment->read_block(file, entry, scratch, block)) {
+                    continue;
+                }
+                for (const auto& sample : block) {
+                    if (sample.Timestamp >= from && sample.Timestamp <= to) {
+                        total.add(sample.Rssi);
+                    }
+                }
+            }
+        }
+
+        std::vector<RssiAggregate> result;
+        result.reserve(totals.size());
+        for (auto& entry : totals) {
+            if (entry.second.Count > 0) {
+                entry.second.Bssid = entry.first;
+                result.push_back(entry.second);
+            }
+        }
+        return result;
+    }
+
+    size_t segment_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return segments_.size();
+    }
+
+private:
+    std::filesystem::path segment_path(uint64_t firstSeq, uint64_t lastSeq) const {
+        return directory_ / ("rssi-" + std::to_string(firstSeq) + "-" + std::to_string(lastSeq) + ".seg");
+    }
+
+    void load_segments() {
+        std::error_code error;
+        std::vector<std::shared_ptr<RssiSegment>> found;
+        for (const auto& item : std::filesystem::directory_iterator(directory_, error)) {
+            const auto& path = item.path();
+            if (path.extension() == ".tmp") {
+                if (!readOnly_) {
+                    std::filesystem::remove(path, error); // Недописанный сегмент после сбоя
+                }
+            } else if (path.extension() == ".seg") {
+                if (auto segment = RssiSegment::open(path)) {
+                    found.push_back(segment);
+                }
+            }
+        }
+
+        // Если слияние упало после записи нового сегмента, но до удаления исходных,
+        // исходные покрыты диапазоном seq нового сегмента и отбрасываются.
+        for (const auto& segment : found) {
+            bool covered = std::any_of(found.begin(), found.end(), [&](const std::shared_ptr<RssiSegment>& other) {
+                return other != segment
+                       && other->header().firstSeq <= segment->header().firstSeq
+                       && other->header().lastSeq >= segment->header().lastSeq;
+            });
+            if (covered) {
+                if (!readOnly_) {
+                    segment->mark_obsolete();
+                }
+            } else {
+                segments_.push_back(segment);
+                nextSeq_ = (std::max)(nextSeq_, segment->header().lastSeq + 1);
+            }
+        }
+        std::sort(segments_.begin(), segments_.end(), [](const std::shared_ptr<RssiSegment>& a, const std::shared_ptr<RssiSegment>& b) {
+            return a->header().firstSeq < b->header().firstSeq;
+        });
+    }
+
+    static int64_t block_window(int64_t timestamp) {
+        int64_t window = timestamp / RSSI_BLOCK_WINDOW_MS;
+        return timestamp % RSSI_BLOCK_WINDOW_MS < 0 ? window - 1 : window;
+    }
+
+    // Ярус сегмента по размеру: 0 до RSSI_TIER_BASE_BYTES, дальше каждый в FANIN раз крупнее.
+    // -1 - сегмент слишком велик и больше не сливается
+    static int segment_tier(const RssiSegment& segment) {
+        if (segment.size() >= RSSI_MAX_COMPACTION_BYTES) {
+            return -1;
+        }
+        int tier = 0;
+        for (uint64_t limit = RSSI_TIER_BASE_BYTES; segment.size() >= limit; limit *= RSSI_COMPACTION_FANIN) {
+            ++tier;
+        }
+        return tier;
+    }
+
+    // Самые старые FANIN соседних сегментов одного яруса; пусто, если сливать нечего.
+    // Сливаются только соседние по seq, чтобы диапазон seq результата оставался непрерывным
+    std::vector<std::shared_ptr<RssiSegment>> pick_compaction_locked() const {
+        size_t runStart = 0;
+        for (size_t i = 0; i < segments_.size(); ++i) {
+            int tier = segment_tier(*segments_[i]);
+            if (tier < 0 || (i > runStart && tier != segment_tier(*segments_[runStart]))) {
+                runStart = tier < 0 ? i + 1 : i;
+                continue;
+            }
+            if (i + 1 - runStart == RSSI_COMPACTION_FANIN) {
+                return std::vector<std::shared_ptr<RssiSegment>>(segments_.begin() + runStart, segments_.begin() + i + 1);
+            }
+        }
+        return {};
+    }
+
+    // Пишет сегмент во временный файл и атомарно переименовывает его
+    std::shared_ptr<RssiSegment> write_segment(uint64_t firstSeq, uint64_t lastSeq, std::map<uint64_t, std::vector<RssiSample>>& blocks) const {
+        std::vector<uint8_t> data(sizeof(RssiSegmentHeader));
+        std::vector<RssiIndexEntry> index;
+        index.reserve(blocks.size());
+
+        RssiSegmentHeader header = {};
+        header.magic = RSSI_SEGMENT_MAGIC;
+        header.version = RSSI_SEGMENT_VERSION;
+        header.firstSeq = firstSeq;
+        header.lastSeq = lastSeq;
+        header.minTimestamp = (std::numeric_limits<int64_t>::max)();
+        header.maxTimestamp = (std::numeric_limits<int64_t>::min)();
+        for (auto& block : blocks) {
+            if (block.second.empty()) {
+                continue;
+            }
+            std::vector<RssiSample>& samples = block.second;
+            std::stable_sort(samples.begin(), samples.end(),
+                             [](const RssiSample& a, const RssiSample& b) { return a.Timestamp < b.Timestamp; });
+            // Нарезаем по часовым окнам, чтобы после слияния запрос за последний
+            // час не декодировал всю историю BSSID
+            std::vector<RssiSample> window;
+            for (size_t i = 0; i < samples.size(); ) {
+                int64_t windowId = block_window(samples[i].Timestamp);
+                size_t end = i;
+                while (end < samples.size() && block_window(samples[end].Timestamp) == windowId) {
+                    ++end;
+                }
+                window.assign(samples.begin() + i, samples.begin() + end);
+                index.push_back(encode_block(block.first, window, data));
+                header.minTimestamp = (std::min)(header.minTimestamp, index.back().minTimestamp);
+                header.maxTimestamp = (std::max)(header.maxTimestamp, index.back().maxTimestamp);
+                i = end;
+            }
+        }
+        header.indexOffset = data.size();
+        header.entryCount = static_cast<uint32_t>(index.size());
+        std::memcpy(data.data(), &header, sizeof(header));
+
+        std::filesystem::path path = segment_path(firstSeq, lastSeq);
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(data.data()), data.size());
+            file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(RssiIndexEntry));
+            if (!file.flush()) {
+                return nullptr;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        if (error) {
+            std::filesystem::remove(tempPath, error);
+            return nullptr;
+        }
+        return RssiSegment::open(path);
+    }
+
+    bool flush_locked() {
+        if (memtableSize_ == 0) {
+            return true;
+        }
+
+        std::map<uint64_t, std::vector<RssiSample>> blocks;
+        for (auto& entry : memtable_) {
+            blocks[entry.first].swap(entry.second);
+        }
+        uint64_t seq = nextSeq_++;
+        auto segment = write_segment(seq, seq, blocks);
+        if (segment == nullptr) {
+            // Возвращаем сэмплы обратно, чтобы попробовать при следующем сбросе
+            for (auto& entry : blocks) {
+                memtable_[entry.first].swap(entry.second);
+            }
+            return false;
+        }
+
+        memtable_.clear();
+        memtableSize_ = 0;
+        segments_.push_back(segment);
+        wakeup_.notify_one();
+        return true;
+    }
+
+    // Сливает соседние сегменты в один. Исходные сегменты неизменяемы,
+    // поэтому чтение и запись идут без блокировки. Прерывается при закрытии хранилища
+    bool compact(const std::vector<std::shared_ptr<RssiSegment>>& inputs) {
+        std::map<uint64_t, std::vector<RssiSample>> blocks;
+        std::vector<uint8_t> scratch;
+        for (const auto& segment : inputs) {
+            std::ifstream file(segment->path(), std::ios::binary);
+            for (const auto& entry : segment->index()) {
+                if (cancelled_ || !file || !segment->read_block(file, entry, scratch, blocks[entry.bssid])) {
+                    return false;
+                }
+            }
+        }
+
+        auto merged = write_segment(inputs.front()->header().firstSeq, inputs.back()->header().lastSeq, blocks);
+        if (merged == nullptr) {
+            return false;
+        }
+
+        // Результат встаёт на место первого из исходных, порядок по seq сохраняется
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::shared_ptr<RssiSegment>> remaining;
+        for (const auto& segment : segments_) {
+            if (segment == inputs.front()) {
+                remaining.push_back(merged);
+            }
+            if (std::find(inputs.begin(), inputs.end(), segment) != inputs.end()) {
+                segment->mark_obsolete();
+            } else {
+                remaining.push_back(segment);
+            }
+        }
+        segments_.swap(remaining);
+        return true;
+    }
+
+    void compaction_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            // После неудачного слияния ждём появления нового сегмента, а не крутимся впустую
+            std::vector<std::shared_ptr<RssiSegment>> inputs;
+            wakeup_.wait(lock, [this, &inputs] {
+                if (stopping_ || segments_.size() < compactionRetrySize_) {
+                    return stopping_;
+                }
+                inputs = pick_compaction_locked();
+                return !inputs.empty();
+            });
+            if (stopping_) {
+                break;
+            }
+            lock.unlock();
+            bool compacted = compact(inputs);
+            inputs.clear();
+            lock.lock();
+            compactionRetrySize_ = compacted ? 0 : segments_.size() + 1;
+        }
+    }
+
+    std::filesystem::path directory_;
+    bool readOnly_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::thread worker_;
+    bool stopping_ = false;
+    std::atomic<bool> cancelled_{false}; // Прерывает идущее слияние при закрытии
+    size_t compactionRetrySize_ = 0;
+    uint64_t nextSeq_ = 0;
+    std::vector<std::shared_ptr<RssiSegment>> segments_;
+    std::unordered_map<uint64_t, std::vector<RssiSample>> memtable_;
+    size_t memtableSize_ = 0;
+};
@@ -0,0 +1,506 @@
+// Язык фильтров для результатов сканирования.
+//
+// Выражение компилируется в программу для стековой машины, которая за один
+// проход по инструкции обрабатывает весь пакет записей в колоночном виде.
+// Любое числовое сравнение сводится к проверке диапазона [low, high], которая
+// на SSE2 обрабатывает 16 значений колонки int32 за итерацию. SSID хранятся
+// словарём: шаблон сопоставляется один раз на уникальную строку, а не на
+// каждую запись.
+//
+// Грамматика:
+//   expr    := and ( ("||" | "or") and )*
+//   and     := unary ( ("&&" | "and") unary )*
+//   unary   := ("!" | "not") unary | "(" expr ")" | "hidden" | compare
+//   compare := ("rssi" | "channel" | "freq" | "band") op number
+//            | "ssid" ("==" | "!=" | "~" | "!~") string
+//   op      := "==" | "!=" | "<" | "<=" | ">" | ">="
+//
+// hidden - пустой SSID: convert_ssid приводит к нему и SSID из нулевых байт.
+// band принимает 2.4, 5 или 6 (ГГц), freq задаётся в МГц, строки в кавычках,
+// "~" сравнивает с шаблоном (* и ?) без учёта регистра.
+// Пример: band == 5 && rssi > -70 && ssid ~ "corp-*" && !hidden
+
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cwchar>
+#include <cwctype>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define SCAN_FILTER_SSE2
+#endif
+
+enum class FilterColumn { Rssi, Channel, Frequency };
+
+enum class FilterOp { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+enum class FilterCode {
+    InRange, // Low <= column <= High, inverted when Negate is set
+    SsidEqual,
+    SsidMatch,
+    Hidden,
+    And,
+    Or,
+    Not,
+};
+
+struct FilterInstruction {
+    FilterCode Code = FilterCode::InRange;
+    FilterColumn Column = FilterColumn::Rssi;
+    int32_t Low = 0;
+    int32_t High = 0;
+    bool Negate = false;
+    std::wstring Pattern = {};
+};
+
+// Пакет записей сканирования в колоночном виде
+struct ScanBatch {
+    std::vector<int32_t> Rssi;
+    std::vector<int32_t> Channel;
+    std::vector<int32_t> Frequency; // MHz
+    std::vector<uint32_t> SsidId; // Index into SsidDictionary
+    std::vector<std::wstring> SsidDictionary;
+    std::unordered_map<std::wstring, uint32_t> SsidLookup;
+
+    size_t size() const { return Rssi.size(); }
+
+    void clear() {
+        Rssi.clear();
+        Channel.clear();
+        Frequency.clear();
+        SsidId.clear();
+        SsidDictionary.clear();
+        SsidLookup.clear();
+    }
+
+    void add(const std::wstring& ssid, int32_t rssi, int32_t frequency) {
+        auto it = SsidLookup.find(ssid);
+        if (it == SsidLookup.end()) {
+            it = SsidLookup.emplace(ssid, static_cast<uint32_t>(SsidDictionary.size())).first;
+            SsidDictionary.push_back(ssid);
+        }
+        Rssi.push_back(rssi);
+        Channel.push_back(frequency_to_channel(frequency));
+        Frequency.push_back(frequency);
+        SsidId.push_back(it->second);
+    }
+
+    static int32_t frequency_to_channel(int32_t frequency) {
+        if (frequency == 2484) {
+            return 14;
+        }
+        if (frequency >= 2412 && frequency < 2484) {
+            return (frequency - 2407) / 5;
+        }
+        if (frequency > 5950 && frequency <= 7125) {
+            return (frequency - 5950) / 5;
+        }
+        if (frequency >= 5000 && frequency <= 5950) {
+            return (frequency - 5000) / 5;
+        }
+        return 0;
+    }
+};
+
+// Сопоставление с шаблоном * и ? без учёта регистра
+inline bool glob_match(const wchar_t* pattern, const wchar_t* text) {
+    const wchar_t* star = nullptr;
+    const wchar_t* resume = nullptr;
+    while (*text) {
+        if (*pattern == L'*') {
+            star = pattern++;
+            resume = text;
+        } else if (*pattern == L'?' || (*pattern && std::towlower(*pattern) == std::towlower(*text))) {
+            ++pattern;
+            ++text;
+        } else if (star != nullptr) {
+            pattern = star + 1;
+            text = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == L'*') {
+        ++pattern;
+    }
+    return *pattern == 0;
+}
+
+class ScanFilter {
+public:
+    // Компилирует выражение. Пустое выражение пропускает все записи.
+    bool compile(const std::wstring& text, std::wstring& error) {
+        std::vector<FilterInstruction> program;
+        text_ = text.c_str();
+        position_ = 0;
+        error.clear();
+
+        skip_spaces();
+        if (text_[position_] != 0) {
+            if (!parse_or(program, error)) {
+                return false;
+            }
+            skip_spaces();
+            if (text_[position_] != 0) {
+                error = L"Unexpected input at position " + std::to_wstring(position_);
+                return false;
+            }
+        }
+        program_.swap(program);
+        return true;
+    }
+
+    bool empty() const { return program_.empty(); }
+
+    // Заполняет mask: 1 для записей, прошедших фильтр, 0 для остальных
+    void run(const ScanBatch& batch, std::vector<uint8_t>& mask) {
+        const size_t count = batch.size();
+        if (program_.empty()) {
+            mask.assign(count, 1);
+            return;
+        }
+
+        size_t depth = 0;
+        for (const auto& instruction : program_) {
+            switch (instruction.Code) {
+                case FilterCode::And:
+                case FilterCode::Or:
+                    combine_masks(stack_[depth - 2].data(), stack_[depth - 1].data(), count, instruction.Code == FilterCode::And);
+                    --depth;
+                    break;
+                case FilterCode::Not:
+                    invert_mask(stack_[depth - 1].data(), count);
+                    break;
+                default: {
+                    if (stack_.size() <= depth) {
+                        stack_.resize(depth + 1);
+                    }
+                    stack_[depth].resize(count);
+                    evaluate(instruction, batch, stack_[depth].data());
+                    ++depth;
+                    break;
+                }
+            }
+        }
+        mask.assign(stack_[0].begin(), stack_[0].begin() + count);
+    }
+
+private:
+    static void range_column(const int32_t* column, size_t count, uint8_t* out, int32_t low, int32_t high, bool negate) {
+        size_t i = 0;
+#ifdef SCAN_FILTER_SSE2
+        const __m128i lowVector = _mm_set1_epi32(low);
+        const __m128i highVector = _mm_set1_epi32(high);
+        const __m128i flip = _mm_set1_epi8(negate ? 0 : 1);
+        const __m128i one = _mm_set1_epi8(1);
+        for (; i + 16 <= count; i += 16) {
+            __m128i outside[4];
+            for (int k = 0; k < 4; ++k) {
+                __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i + 4 * k));
+                outside[k] = _mm_or_si128(_mm_cmplt_epi32(value, lowVector), _mm_cmpgt_epi32(value, highVector));
+            }
+            // Маски 4x4 int32 упаковываются в 16 байтов со знаковым насыщением (-1 или 0)
+            __m128i packed = _mm_packs_epi16(_mm_packs_epi32(outside[0], outside[1]), _mm_packs_epi32(outside[2], outside[3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(_mm_and_si128(packed, one), flip));
+        }
+#endif
+        for (; i < count; ++i) {
+            bool inside = column[i] >= low && column[i] <= high;
+            out[i] = inside != negate ? 1 : 0;
+        }
+    }
+
+    static void combine_masks(uint8_t* left, const uint8_t* right, size_t count, bool conjunction) {
+        size_t i = 0;
+#ifdef SCAN_FILTER_SSE2
+        for (; i + 16 <= count; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(left + i), conjunction ? _mm_and_si128(a, b) : _mm_or_si128(a, b));
+        }
+#endif
+        for (; i < count; ++i) {
+            left[i] = conjunction ? (left[i] & right[i]) : (left[i] | right[i]);
+        }
+    }
+
+    static void invert_mask(uint8_t* mask, size_t count) {
+        size_t i = 0;
+#ifdef SCAN_FILTER_SSE2
+        const __m128i one = _mm_set1_epi8(1);
+        for (; i + 16 <= count; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(mask + i), _mm_xor_si128(a, one));
+        }
+#endif
+        for (; i < count; ++i) {
+            mask[i] ^= 1;
+        }
+    }
+
+    static void evaluate(const FilterInstruction& instruction, const ScanBatch& batch, uint8_t* out) {
+        const size_t count = batch.size();
+        const int32_t* column = instruction.Column == FilterColumn::Rssi ? batch.Rssi.data()
+                              : instruction.Column == FilterColumn::Channel ? batch.Channel.data()
+                              : batch.Frequency.data();
+
+        switch (instruction.Code) {
+            case FilterCode::InRange:
+                range_column(column, count, out, instruction.Low, instruction.High, instruction.Negate);
+                break;
+
+            case FilterCode::SsidEqual:
+            case FilterCode::SsidMatch:
+            case FilterCode::Hidden: {
+                // Сначала проверяем каждую уникальную строку, затем раздаём результат по записям
+                std::vector<uint8_t> matches(batch.SsidDictionary.size());
+                for (size_t i = 0; i < matches.size(); ++i) {
+                    const std::wstring& ssid = batch.SsidDictionary[i];
+                    if (instruction.Code == FilterCode::Hidden) {
+                        matches[i] = ssid.empty();
+                    } else if (instruction.Code == FilterCode::SsidEqual) {
+                        matches[i] = ssid == instruction.Pattern;
+                    } else {
+                        matches[i] = glob_match(instruction.Pattern.c_str(), ssid.c_str());
+                    }
+                }
+                const uint32_t* ids = batch.SsidId.data();
+                for (size_t i = 0; i < count; ++i) {
+                    out[i] = matches[ids[i]];
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    void skip_spaces() {
+        while (std::iswspace(text_[position_])) {
+            ++position_;
+        }
+    }
+
+    bool accept(const wchar_t* token) {
+        skip_spaces();
+        size_t length = std::char_traits<wchar_t>::length(token);
+        if (std::char_traits<wchar_t>::compare(text_ + position_, token, length) != 0) {
+            return false;
+        }
+        // Слова-операторы не должны быть префиксом идентификатора
+        if (std::iswalpha(token[0]) && std::iswalnum(text_[position_ + length])) {
+            return false;
+        }
+        position_ += length;
+        return true;
+    }
+
+    bool parse_or(std::vector<FilterInstruction>& program, std::wstring& error) {
+        if (!parse_and(program, error)) {
+            return false;
+        }
+        while (accept(L"||") || accept(L"or")) {
+            if (!parse_and(program, error)) {
+                return false;
+            }
+            program.push_back({ FilterCode::Or });
+        }
+        return true;
+    }
+
+    bool parse_and(std::vector<FilterInstruction>& program, std::wstring& error) {
+        if (!parse_unary(program, error)) {
+            return false;
+        }
+        while (accept(L"&&") || accept(L"and")) {
+            if (!parse_unary(program, error)) {
+                return false;
+            }
+            program.push_back({ FilterCode::And });
+        }
+        return true;
+    }
+
+    bool parse_unary(std::vector<FilterInstruction>& program, std::wstring& error) {
+        if (accept(L"!") || accept(L"not")) {
+            if (!parse_unary(program, error)) {
+                return false;
+            }
+            program.push_back({ FilterCode::Not });
+            return true;
+        }
+        if (accept(L"(")) {
+            if (!parse_or(program, error)) {
+                return false;
+            }
+            if (!accept(L")")) {
+                error = L"Expected ')' at position " + std::to_wstring(position_);
+                return false;
+            }
+            return true;
+        }
+        if (accept(L"hidden")) {
+            program.push_back({ FilterCode::Hidden });
+            return true;
+        }
+        if (accept(L"ssid")) {
+            return parse_ssid(program, error);
+        }
+
+        FilterColumn column;
+        bool isBand = false;
+        if (accept(L"rssi")) {
+            column = FilterColumn::Rssi;
+        } else if (accept(L"channel")) {
+            column = FilterColumn::Channel;
+        } else if (accept(L"freq")) {
+            column = FilterColumn::Frequency;
+        } else if (accept(L"band")) {
+            column = FilterColumn::Frequency;
+            isBand = true;
+        } else {
+            error = L"Expected a field name at position " + std::to_wstring(position_);
+            return false;
+        }
+
+        FilterOp op;
+        if (!parse_op(op)) {
+            error = L"Expected a comparison operator at position " + std::to_wstring(position_);
+            return false;
+        }
+        double number;
+        if (!parse_number(number)) {
+            error = L"Expected a number at position " + std::to_wstring(position_);
+            return false;
+        }
+
+        if (!isBand) {
+            // Сравнение переводится в диапазон; пустой диапазон [1, 0] не пропускает ничего
+            // Границы считаются от дробного числа: rssi > -70.5 - это rssi >= -70.
+            // Число заранее ограничено чуть шире int32, чтобы приведение было определено
+            double clamped = (std::min)((std::max)(number, static_cast<double>(INT32_MIN) - 1), static_cast<double>(INT32_MAX) + 1);
+            int64_t floorValue = static_cast<int64_t>(std::floor(clamped));
+            int64_t ceilValue = static_cast<int64_t>(std::ceil(clamped));
+            int64_t low = INT32_MIN, high = INT32_MAX;
+            bool negate = false;
+            switch (op) {
+                // Дробное число не равно ни одному целому: пустой диапазон
+                case FilterOp::Equal: low = ceilValue; high = floorValue; break;
+                case FilterOp::NotEqual: low = ceilValue; high = floorValue; negate = true; break;
+                case FilterOp::Less: high = ceilValue - 1; break;
+                case FilterOp::LessEqual: high = floorValue; break;
+                case FilterOp::Greater: low = floorValue + 1; break;
+                case FilterOp::GreaterEqual: low = ceilValue; break;
+            }
+            low = (std::max)(low, static_cast<int64_t>(INT32_MIN));
+            high = (std::min)(high, static_cast<int64_t>(INT32_MAX));
+            if (low > high) {
+                low = 1;
+                high = 0;
+            }
+            FilterInstruction instruction = { FilterCode::InRange, column, static_cast<int32_t>(low), static_cast<int32_t>(high), negate };
+            program.push_back(instruction);
+            return true;
+        }
+
+        // Диапазон band переводится в диапазон частот в МГц
+        int32_t low, high;
+        if (number == 2.4) {
+            low = 2400; high = 2500;
+        } else if (number == 5) {
+            low = 4900; high = 5925;
+        } else if (number == 6) {
+            low = 5926; high = 7125;
+        } else {
+            error = L"Band must be 2.4, 5 or 6";
+            return false;
+        }
+        if (op != FilterOp::Equal && op != FilterOp::NotEqual) {
+            error = L"Band supports only == and !=";
+            return false;
+        }
+        FilterInstruction instruction = { FilterCode::InRange, column, low, high, op == FilterOp::NotEqual };
+        program.push_back(instruction);
+        return true;
+    }
+
+    bool parse_ssid(std::vector<FilterInstruction>& program, std::wstring& error) {
+        FilterCode code;
+        bool negate = false;
+        if (accept(L"==")) {
+            code = FilterCode::SsidEqual;
+        } else if (accept(L"!=")) {
+            code = FilterCode::SsidEqual;
+            negate = true;
+        } else if (accept(L"~")) {
+            code = FilterCode::SsidMatch;
+        } else if (accept(L"!~")) {
+            code = FilterCode::SsidMatch;
+            negate = true;
+        } else {
+            error = L"Expected ==, !=, ~ or !~ after ssid at position " + std::to_wstring(position_);
+            return false;
+        }
+
+        skip_spaces();
+        wchar_t quote = text_[position_];
+        if (quote != L'"' && quote != L'\'') {
+            error = L"Expected a quoted string at position " + std::to_wstring(position_);
+            return false;
+        }
+        size_t start = ++position_;
+        while (text_[position_] != 0 && text_[position_] != quote) {
+            ++position_;
+        }
+        if (text_[position_] != quote) {
+            error = L"Unterminated string at position " + std::to_wstring(start - 1);
+            return false;
+        }
+
+        FilterInstruction instruction = { code };
+        instruction.Pattern.assign(text_ + start, position_ - start);
+        ++position_;
+        program.push_back(instruction);
+        if (negate) {
+            program.push_back({ FilterCode::Not });
+        }
+        return true;
+    }
+
+    bool parse_op(FilterOp& op) {
+        if (accept(L"==")) op = FilterOp::Equal;
+        else if (accept(L"!=")) op = FilterOp::NotEqual;
+        else if (accept(L"<=")) op = FilterOp::LessEqual;
+        else if (accept(L">=")) op = FilterOp::GreaterEqual;
+        else if (accept(L"<")) op = FilterOp::Less;
+        else if (accept(L">")) op = FilterOp::Greater;
+        else return false;
+        return true;
+    }
+
+    bool parse_number(double& number) {
+        skip_spaces();
+        const wchar_t* start = text_ + position_;
+        wchar_t* end = nullptr;
+        number = std::wcstod(start, &end);
+        // wcstod принимает nan и inf, для сравнения с целыми столбцами они не годятся
+        if (end == start || !std::isfinite(number)) {
+            return false;
+        }
+        position_ += end - start;
+        return true;
+    }
+
+    std::vector<FilterInstruction> program_;
+    std::vector<std::vector<uint8_t>> stack_;
+    const wchar_t* text_ = L"";
+    size_t position_ = 0;
+};
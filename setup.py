@@ -0,0 +1,21 @@
+import sys
+
+from setuptools import Extension, setup
+
+# Сборка модуля wifi_native: python setup.py build_ext --inplace
+libraries = ['wlanapi'] if sys.platform == 'win32' else []
+extra_compile_args = ['/std:c++17'] if sys.platform == 'win32' and 'GCC' not in sys.version else ['-std=c++17']
+
+setup(
+    name='wifi_native',
+    version='0.1.0',
+    description='Native Wi-Fi scan, distance model and radar positioning',
+    ext_modules=[
+        Extension(
+            'wifi_native',
+            sources=['wifi_native.cpp'],
+            libraries=libraries,
+            extra_compile_args=extra_compile_args,
+        ),
+    ],
+)
@@ -15,27 +15,62 @@
 #include <algorithm>
 #include <random>
 #include <map>
+#include <cstring>
+#include <shellapi.h>
+#include "scan_filter.h"
+#include "wifi_core.h"
 
 #pragma comment(lib, "comctl32.lib")
 #pragma comment(lib, "wlanapi.lib")
 #pragma comment(lib, "gdiplus.lib")
 #pragma comment(lib, "gdi32.lib")
+#pragma comment(lib, "shell32.lib")
 
 using namespace Gdiplus;
 
 const double FREQUENCY = 2.4; // Frequency in GHz
+const wchar_t STATE_FILE_NAME[] = L"wifi-radar.state";
+const DWORD STATE_MAGIC = 0x53524657; // "WFRS"
+const DWORD STATE_VERSION = 1;
+const UINT SNAPSHOT_INTERVAL_MS = 30000;
 
 struct Network {
     std::wstring SSID;
     std::wstring BSSID;
     int Signal; // Signal strength in dBm
+    int Frequency; // Channel center frequency in MHz
     double Distance; // Calculated distance
     double X; // X coordinate
     double Y; // Y coordinate
     bool isCoordinateSet = false; // Flag to check if coordinates are already set
 };
 
+// Заголовок файла снимка состояния. За ним идут две секции записей
+// (savedCoordinates, затем previousCoordinates), каждая запись:
+// double X, double Y, WORD длина SSID, WCHAR[длина] SSID.
+#pragma pack(push, 1)
+struct StateHeader {
+    DWORD magic;
+    DWORD version;
+    DWORD payloadSize;
+    DWORD checksum; // FNV-1a over the payload
+    double scale;
+    DWORD savedCount;
+    DWORD previousCount;
+};
+#pragma pack(pop)
+
+struct SnapshotJob {
+    std::wstring path;
+    std::vector<char> buffer;
+};
+
+static volatile LONG snapshotInProgress = 0;
+
 std::wstring convert_ssid(const BYTE* ssid, DWORD length) {
+    if (is_hidden_ssid(ssid, length)) {
+        return L""; // Скрытая сеть
+    }
     int requiredSize = MultiByteToWideChar(CP_UTF8, 0, (LPCCH)ssid, length, NULL, 0);
     if (requiredSize > 0) {
         std::wstring wide_ssid(requiredSize, 0);
@@ -52,103 +87,66 @@ std::wstring convert_ssid(const BYTE* ssid, DWORD length) {
     }
 }
 
-double calculate_distance(double rssi, double frequency) {
-    const double RSSI_0 = -40;
-    const double path_loss_exponent = 3.0;
-
-    if (rssi > 0) {
-        return -1;
-    }
-
-    double distance = std::pow(10, (RSSI_0 - rssi) / (10 * path_loss_exponent));
-    return distance;
-}
-
 std::vector<Network> get_wifi_networks() {
     std::vector<Network> networks;
-    HANDLE hClient = NULL;
-    DWORD dwMaxClient = 2;
-    DWORD dwCurVersion = 0;
+    for_each_bss_entry([&networks](const WLAN_BSS_ENTRY& entry) {
+        Network network;
+        network.SSID = convert_ssid(entry.dot11Ssid.ucSSID, entry.dot11Ssid.uSSIDLength);
+        network.BSSID = L"";
+        for (int k = 0; k < 6; k++) {
+            wchar_t buffer[3];
+            swprintf(buffer, 3, L"%02X", entry.dot11Bssid[k]);
+            network.BSSID += buffer;
+            if (k < 5) network.BSSID += L":";
+        }
+        network.Signal = entry.lRssi;
+        network.Frequency = entry.ulChCenterFrequency / 1000;
+        network.Distance = calculate_distance(network.Signal, FREQUENCY);
+        networks.push_back(network);
+    });
+    return networks;
+}
 
-    if (WlanOpenHandle(dwMaxClient, NULL, &dwCurVersion, &hClient) != ERROR_SUCCESS) {
-        std::wcerr << L"Failed to open WLAN handle." << std::endl;
-        return networks;
+void filter_networks(ScanFilter& filter, std::vector<Network>& networks) {
+    if (filter.empty()) {
+        return;
     }
 
-    PWLAN_INTERFACE_INFO_LIST pIfList = NULL;
-    if (WlanEnumInterfaces(hClient, NULL, &pIfList) != ERROR_SUCCESS) {
-        std::wcerr << L"Failed to enumerate WLAN interfaces." << std::endl;
-        WlanCloseHandle(hClient, NULL);
-        return networks;
+    ScanBatch batch;
+    for (const auto& network : networks) {
+        batch.add(network.SSID, network.Signal, network.Frequency);
     }
-
-    if (pIfList != NULL) {
-        for (int i = 0; i < (int)pIfList->dwNumberOfItems; i++) {
-            PWLAN_INTERFACE_INFO pIfInfo = &pIfList->InterfaceInfo[i];
-
-            // Выполняем сканирование перед получением списка сетей
-            if (WlanScan(hClient, &pIfInfo->InterfaceGuid, NULL, NULL, NULL) != ERROR_SUCCESS) {
-                std::wcerr << L"Failed to scan networks for interface " << i << std::endl;
-                continue;
-            }
-
-            PWLAN_BSS_LIST pBssList = NULL;
-            if (WlanGetNetworkBssList(hClient, &pIfInfo->InterfaceGuid, NULL, dot11_BSS_type_any, FALSE, NULL, &pBssList) == ERROR_SUCCESS) {
-                if (pBssList != NULL) {
-                    for (unsigned int j = 0; j < pBssList->dwNumberOfItems; j++) {
-                        PWLAN_BSS_ENTRY pBssEntry = &pBssList->wlanBssEntries[j];
-
-                        Network network;
-                        network.SSID = convert_ssid(pBssEntry->dot11Ssid.ucSSID, pBssEntry->dot11Ssid.uSSIDLength);
-                        network.BSSID = L"";
-                        for (int k = 0; k < 6; k++) {
-                            wchar_t buffer[3];
-                            swprintf(buffer, 3, L"%02X", pBssEntry->dot11Bssid[k]);
-                            network.BSSID += buffer;
-                            if (k < 5) network.BSSID += L":";
-                        }
-                        network.Signal = pBssEntry->lRssi;
-                        network.Distance = calculate_distance(network.Signal, FREQUENCY);
-                        networks.push_back(network);
-                    }
-                    WlanFreeMemory(pBssList);
-                }
-            } else {
-                std::wcerr << L"Failed to get BSS list for interface " << i << std::endl;
+    std::vector<uint8_t> mask;
+    filter.run(batch, mask);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < networks.size(); ++i) {
+        if (mask[i]) {
+            if (kept != i) {
+                networks[kept] = std::move(networks[i]);
             }
+            ++kept;
         }
-        WlanFreeMemory(pIfList);
     }
-
-    WlanCloseHandle(hClient, NULL);
-    return networks;
+    networks.resize(kept);
 }
 
 void calculate_coordinates(std::vector<Network>& networks, std::map<std::wstring, std::pair<double, double>>& savedCoordinates) {
     std::random_device rd;
     std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0, 2 * M_PI);
 
     for (auto& network : networks) {
-        if (savedCoordinates.find(network.SSID) != savedCoordinates.end()) {
-            network.X = savedCoordinates[network.SSID].first;
-            network.Y = savedCoordinates[network.SSID].second;
-        } else {
-            double angle = dis(gen);
-            network.X = network.Distance * std::cos(angle);
-            network.Y = network.Distance * std::sin(angle);
-            savedCoordinates[network.SSID] = {network.X, network.Y};
-        }
+        std::pair<double, double> point = place_point(network.SSID, network.Distance, savedCoordinates, gen);
+        network.X = point.first;
+        network.Y = point.second;
     }
 }
 
 void smooth_coordinates(std::vector<Network>& networks, std::map<std::wstring, std::pair<double, double>>& previousCoordinates, double alpha = 0.2) {
     for (auto& network : networks) {
-        if (previousCoordinates.find(network.SSID) != previousCoordinates.end()) {
-            network.X = alpha * network.X + (1 - alpha) * previousCoordinates[network.SSID].first;
-            network.Y = alpha * network.Y + (1 - alpha) * previousCoordinates[network.SSID].second;
-        }
-        previousCoordinates[network.SSID] = {network.X, network.Y};
+        std::pair<double, double> point = smooth_point(network.SSID, std::make_pair(network.X, network.Y), previousCoordinates, alpha);
+        network.X = point.first;
+        network.Y = point.second;
     }
 }
 
@@ -164,6 +162,222 @@ void correct_coordinates(std::vector<Network>& networks) {
     }
 }
 
+std::wstring get_state_path() {
+    wchar_t modulePath[MAX_PATH];
+    DWORD length = GetModuleFileNameW(NULL, modulePath, MAX_PATH);
+    if (length == 0 || length == MAX_PATH) {
+        return STATE_FILE_NAME;
+    }
+    std::wstring path(modulePath, length);
+    size_t slash = path.find_last_of(L"\\/");
+    return (slash == std::wstring::npos ? std::wstring() : path.substr(0, slash + 1)) + STATE_FILE_NAME;
+}
+
+DWORD state_checksum(const char* data, size_t size) {
+    DWORD hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void append_coordinates(std::vector<char>& buffer, const std::map<std::wstring, std::pair<double, double>>& coordinates) {
+    for (const auto& entry : coordinates) {
+        WORD length = static_cast<WORD>(std::min<size_t>(entry.first.size(), 0xFFFF));
+        size_t offset = buffer.size();
+        buffer.resize(offset + 2 * sizeof(double) + sizeof(WORD) + length * sizeof(wchar_t));
+        char* out = buffer.data() + offset;
+        memcpy(out, &entry.second.first, sizeof(double));
+        memcpy(out + sizeof(double), &entry.second.second, sizeof(double));
+        memcpy(out + 2 * sizeof(double), &length, sizeof(WORD));
+        memcpy(out + 2 * sizeof(double) + sizeof(WORD), entry.first.data(), length * sizeof(wchar_t));
+    }
+}
+
+std::vector<char> serialize_state(const std::map<std::wstring, std::pair<double, double>>& savedCoordinates,
+                                  const std::map<std::wstring, std::pair<double, double>>& previousCoordinates,
+                                  double scale) {
+    std::vector<char> buffer(sizeof(StateHeader));
+    append_coordinates(buffer, savedCoordinates);
+    append_coordinates(buffer, previousCoordinates);
+
+    StateHeader header = {};
+    header.magic = STATE_MAGIC;
+    header.version = STATE_VERSION;
+    header.payloadSize = static_cast<DWORD>(buffer.size() - sizeof(StateHeader));
+    header.checksum = state_checksum(buffer.data() + sizeof(StateHeader), header.payloadSize);
+    header.scale = scale;
+    header.savedCount = static_cast<DWORD>(savedCoordinates.size());
+    header.previousCount = static_cast<DWORD>(previousCoordinates.size());
+    memcpy(buffer.data(), &header, sizeof(header));
+    return buffer;
+}
+
+bool write_state_file(const std::wstring& path, const std::vector<char>& buffer) {
+    std::wstring tempPath = path + L".tmp";
+    HANDLE hFile = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    DWORD written = 0;
+    bool ok = WriteFile(hFile, buffer.data(), static_cast<DWORD>(buffer.size()), &written, NULL)
+              && written == buffer.size()
+              && FlushFileBuffers(hFile);
+    CloseHandle(hFile);
+    if (!ok) {
+        DeleteFileW(tempPath.c_str());
+        return false;
+    }
+
+    // Атомарная замена: после сбоя на диске остаётся либо старый, либо новый снимок
+    return MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+DWORD WINAPI snapshot_thread(LPVOID param) {
+    SnapshotJob* job = static_cast<SnapshotJob*>(param);
+    if (!write_state_file(job->path, job->buffer)) {
+        std::wcerr << L"Failed to write state snapshot." << std::endl;
+    }
+    delete job;
+    InterlockedExchange(&snapshotInProgress, 0);
+    return 0;
+}
+
+// Сериализует состояние в потоке UI и отдаёт запись на диск фоновому потоку
+bool save_state_async(const std::wstring& path,
+                      const std::map<std::wstring, std::pair<double, double>>& savedCoordinates,
+                      const std::map<std::wstring, std::pair<double, double>>& previousCoordinates,
+                      double scale) {
+    if (InterlockedCompareExchange(&snapshotInProgress, 1, 0) != 0) {
+        return false; // Предыдущий снимок ещё пишется, следующий таймер попробует снова
+    }
+
+    SnapshotJob* job = new SnapshotJob{ path, serialize_state(savedCoordinates, previousCoordinates, scale) };
+    HANDLE hThread = CreateThread(NULL, 0, snapshot_thread, job, 0, NULL);
+    if (hThread == NULL) {
+        std::wcerr << L"Failed to start snapshot thread." << std::endl;
+        delete job;
+        InterlockedExchange(&snapshotInProgress, 0);
+        return false;
+    }
+    CloseHandle(hThread);
+    return true;
+}
+
+void save_state_sync(const std::wstring& path,
+                     const std::map<std::wstring, std::pair<double, double>>& savedCoordinates,
+                     const std::map<std::wstring, std::pair<double, double>>& previousCoordinates,
+                     double scale) {
+    // Дожидаемся фоновой записи, чтобы не писать в один и тот же временный файл
+    while (InterlockedCompareExchange(&snapshotInProgress, 1, 0) != 0) {
+        Sleep(1);
+    }
+    if (!write_state_file(path, serialize_state(savedCoordinates, previousCoordinates, scale))) {
+        std::wcerr << L"Failed to write state snapshot." << std::endl;
+    }
+    InterlockedExchange(&snapshotInProgress, 0);
+}
+
+bool read_coordinates(const char*& cursor, const char* end, DWORD count, std::map<std::wstring, std::pair<double, double>>& coordinates) {
+    const size_t fixedSize = 2 * sizeof(double) + sizeof(WORD);
+    for (DWORD i = 0; i < count; ++i) {
+        if (static_cast<size_t>(end - cursor) < fixedSize) {
+            return false;
+        }
+        double x, y;
+        WORD length;
+        memcpy(&x, cursor, sizeof(double));
+        memcpy(&y, cursor + sizeof(double), sizeof(double));
+        memcpy(&length, cursor + 2 * sizeof(double), sizeof(WORD));
+        cursor += fixedSize;
+
+        if (static_cast<size_t>(end - cursor) < length * sizeof(wchar_t)) {
+            return false;
+        }
+        std::wstring ssid(length, 0);
+        memcpy(&ssid[0], cursor, length * sizeof(wchar_t));
+        cursor += length * sizeof(wchar_t);
+
+        // Записи сохранены в порядке std::map, поэтому вставка с подсказкой end() выполняется за O(1)
+        coordinates.emplace_hint(coordinates.end(), std::move(ssid), std::make_pair(x, y));
+    }
+    return true;
+}
+
+bool parse_state(const char* data, size_t size,
+                 std::map<std::wstring, std::pair<double, double>>& savedCoordinates,
+                 std::map<std::wstring, std::pair<double, double>>& previousCoordinates,
+                 double& scale) {
+    if (size < sizeof(StateHeader)) {
+        return false;
+    }
+
+    StateHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != STATE_MAGIC || header.version != STATE_VERSION
+        || header.payloadSize != size - sizeof(StateHeader)
+        || !(header.scale > 0) || !std::isfinite(header.scale)) {
+        return false;
+    }
+
+    const char* cursor = data + sizeof(StateHeader);
+    const char* end = cursor + header.payloadSize;
+    if (state_checksum(cursor, header.payloadSize) != header.checksum) {
+        return false;
+    }
+
+    std::map<std::wstring, std::pair<double, double>> saved;
+    std::map<std::wstring, std::pair<double, double>> previous;
+    if (!read_coordinates(cursor, end, header.savedCount, saved)
+        || !read_coordinates(cursor, end, header.previousCount, previous)) {
+        return false;
+    }
+
+    savedCoordinates.swap(saved);
+    previousCoordinates.swap(previous);
+    scale = header.scale;
+    return true;
+}
+
+bool load_state(const std::wstring& path,
+                std::map<std::wstring, std::pair<double, double>>& savedCoordinates,
+                std::map<std::wstring, std::pair<double, double>>& previousCoordinates,
+                double& scale) {
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(StateHeader) || fileSize.QuadPart > MAXDWORD) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    // Отображаем файл в память, чтобы разбирать снимок без промежуточного буфера
+    HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMapping == NULL) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    bool ok = false;
+    const char* view = static_cast<const char*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (view != NULL) {
+        ok = parse_state(view, static_cast<size_t>(fileSize.QuadPart), savedCoordinates, previousCoordinates, scale);
+        UnmapViewOfFile(view);
+    }
+    CloseHandle(hMapping);
+    CloseHandle(hFile);
+
+    if (!ok) {
+        std::wcerr << L"State snapshot is corrupt or incompatible, starting fresh." << std::endl;
+    }
+    return ok;
+}
+
 void plot_radar(HDC hdc, const std::vector<Network>& networks, int width, int height, double scale, double sonarAngle) {
     if (hdc == NULL) {
         std::wcerr << L"Invalid HDC" << std::endl;
@@ -234,24 +448,40 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     static std::map<std::wstring, std::pair<double, double>> previousCoordinates;
     static double scale = 1.0;
     static double sonarAngle = 0.0;
+    static std::wstring statePath;
+    static bool stateDirty = false;
+    static ScanFilter* filter = nullptr;
     switch (uMsg) {
         case WM_CREATE: {
+            filter = reinterpret_cast<ScanFilter*>(reinterpret_cast<LPCREATESTRUCT>(lParam)->lpCreateParams);
+            statePath = get_state_path();
+            load_state(statePath, savedCoordinates, previousCoordinates, scale);
             SetTimer(hwnd, 1, 2000, nullptr);
             SetTimer(hwnd, 2, 50, nullptr); // Таймер для сонара
+            SetTimer(hwnd, 3, SNAPSHOT_INTERVAL_MS, nullptr); // Таймер для снимков состояния
         }
         break;
 
         case WM_TIMER: {
             if (wParam == 1) {
                 networks = get_wifi_networks();
+                if (filter != nullptr) {
+                    filter_networks(*filter, networks);
+                }
                 calculate_coordinates(networks, savedCoordinates);
                 smooth_coordinates(networks, previousCoordinates);
                 correct_coordinates(networks);
+                stateDirty = true;
             } else if (wParam == 2) {
                 sonarAngle += 0.1; // Угол сонара
                 if (sonarAngle >= 2 * M_PI) {
                     sonarAngle = 0.0;
                 }
+            } else if (wParam == 3) {
+                if (stateDirty && save_state_async(statePath, savedCoordinates, previousCoordinates, scale)) {
+                    stateDirty = false;
+                }
+                break;
             }
             InvalidateRect(hwnd, NULL, TRUE);
         }
@@ -274,6 +504,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             } else {
                 scale /= 1.1;
             }
+            stateDirty = true;
             InvalidateRect(hwnd, NULL, TRUE);
         }
         break;
@@ -281,6 +512,8 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         case WM_DESTROY:
             KillTimer(hwnd, 1);
             KillTimer(hwnd, 2);
+            KillTimer(hwnd, 3);
+            save_state_sync(statePath, savedCoordinates, previousCoordinates, scale);
             PostQuitMessage(0);
             break;
 
@@ -302,6 +535,26 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
         return -1;
     }
 
+    // Аргументы командной строки образуют выражение фильтра,
+    // например: wifi-checker.exe "band == 5 && ssid ~ 'corp-*'"
+    ScanFilter filter;
+    std::wstring filterText;
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv != NULL) {
+        for (int i = 1; i < argc; ++i) {
+            if (!filterText.empty()) filterText += L" ";
+            filterText += argv[i];
+        }
+        LocalFree(argv);
+    }
+    std::wstring filterError;
+    if (!filter.compile(filterText, filterError)) {
+        MessageBox(NULL, (L"Invalid filter: " + filterError).c_str(), L"Error", MB_OK | MB_ICONERROR);
+        GdiplusShutdown(gdiplusToken);
+        return -1;
+    }
+
     const wchar_t CLASS_NAME[] = L"WiFiRadar";
 
     WNDCLASSW wc = {};
@@ -322,7 +575,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
         L"Wi-Fi Radar",
         WS_OVERLAPPEDWINDOW,
         CW_USEDEFAULT, CW_USEDEFAULT, 800, 600,
-        nullptr, nullptr, hInstance, nullptr
+        nullptr, nullptr, hInstance, &filter
     );
 
     if (hwnd == nullptr) {
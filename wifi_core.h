@@ -0,0 +1,194 @@
+// Общее ядро сканирования и позиционирования: используется checkpower,
+// wifi-checker и модулем Python wifi_native. Сканирование доступно только в
+// Windows (WLAN API), модель расстояния и позиционирование переносимы.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <wlanapi.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+const double RSSI_AT_ONE_METER = -40; // Среднее значение RSSI на расстоянии 1 метр
+const double PATH_LOSS_EXPONENT = 3.0; // Показатель затухания пути
+
+// Скрытая сеть передаёт пустой SSID или SSID из нулевых байт той же длины
+inline bool is_hidden_ssid(const uint8_t* ssid, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        if (ssid[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline double calculate_distance(double rssi, double frequency) {
+    if (rssi > 0) {
+        return -1;
+    }
+
+    double distance = std::pow(10, (RSSI_AT_ONE_METER - rssi) / (10 * PATH_LOSS_EXPONENT));
+    return distance;
+}
+
+// Возвращает сохранённую позицию точки или размещает её на окружности
+// радиусом distance под случайным углом и запоминает
+template <typename Key, typename Generator>
+std::pair<double, double> place_point(const Key& key, double distance, std::map<Key, std::pair<double, double>>& savedCoordinates, Generator& gen) {
+    auto it = savedCoordinates.find(key);
+    if (it != savedCoordinates.end()) {
+        return it->second;
+    }
+
+    std::uniform_real_distribution<> dis(0, 2 * M_PI);
+    double angle = dis(gen);
+    std::pair<double, double> point(distance * std::cos(angle), distance * std::sin(angle));
+    savedCoordinates.emplace(key, point);
+    return point;
+}
+
+// Экспоненциальное сглаживание позиции относительно предыдущей
+template <typename Key>
+std::pair<double, double> smooth_point(const Key& key, std::pair<double, double> point, std::map<Key, std::pair<double, double>>& previousCoordinates, double alpha) {
+    auto it = previousCoordinates.find(key);
+    if (it != previousCoordinates.end()) {
+        point.first = alpha * point.first + (1 - alpha) * it->second.first;
+        point.second = alpha * point.second + (1 - alpha) * it->second.second;
+        it->second = point;
+    } else {
+        previousCoordinates.emplace(key, point);
+    }
+    return point;
+}
+
+#ifdef _WIN32
+
+struct ScanWaitContext {
+    HANDLE event;
+    volatile LONG pending; // Интерфейсы, по которым ещё ждём завершения сканирования (+1, пока они запускаются)
+    std::vector<GUID> interfaces;
+    std::vector<LONG> finished; // 0, пока ждём сканирования интерфейса
+};
+
+// Отмечает интерфейс завершённым один раз, даже если уведомлений пришло несколько
+inline void finish_scan(ScanWaitContext* wait, size_t index) {
+    if (InterlockedExchange(&wait->finished[index], 1) == 0 && InterlockedDecrement(&wait->pending) == 0) {
+        SetEvent(wait->event);
+    }
+}
+
+inline VOID WINAPI scan_notification_callback(PWLAN_NOTIFICATION_DATA data, PVOID context) {
+    ScanWaitContext* wait = static_cast<ScanWaitContext*>(context);
+    if (data->NotificationSource == WLAN_NOTIFICATION_SOURCE_ACM
+        && (data->NotificationCode == wlan_notification_acm_scan_complete
+            || data->NotificationCode == wlan_notification_acm_scan_fail)) {
+        for (size_t i = 0; i < wait->interfaces.size(); ++i) {
+            if (IsEqualGUID(data->InterfaceGuid, wait->interfaces[i])) {
+                finish_scan(wait, i);
+            }
+        }
+    }
+}
+
+// Вызывает callback(const WLAN_BSS_ENTRY&) для каждой точки доступа на всех
+// интерфейсах. При scanTimeoutMs > 0 перед чтением списка ждёт уведомления о
+// завершении сканирования (не дольше scanTimeoutMs), иначе читает кэш драйвера.
+template <typename Callback>
+bool for_each_bss_entry(Callback callback, DWORD scanTimeoutMs = 0) {
+    HANDLE hClient = NULL;
+    DWORD dwMaxClient = 2;
+    DWORD dwCurVersion = 0;
+
+    if (WlanOpenHandle(dwMaxClient, NULL, &dwCurVersion, &hClient) != ERROR_SUCCESS) {
+        std::wcerr << L"Failed to open WLAN handle." << std::endl;
+        return false;
+    }
+
+    PWLAN_INTERFACE_INFO_LIST pIfList = NULL;
+    if (WlanEnumInterfaces(hClient, NULL, &pIfList) != ERROR_SUCCESS) {
+        std::wcerr << L"Failed to enumerate WLAN interfaces." << std::endl;
+        WlanCloseHandle(hClient, NULL);
+        return false;
+    }
+
+    ScanWaitContext wait;
+    wait.event = NULL;
+    wait.pending = 0;
+    if (pIfList != NULL) {
+        if (scanTimeoutMs > 0) {
+            // Список интерфейсов заполняется до регистрации, колбэк только читает его
+            for (int i = 0; i < (int)pIfList->dwNumberOfItems; i++) {
+                wait.interfaces.push_back(pIfList->InterfaceInfo[i].InterfaceGuid);
+            }
+            // Пока сканирование не запрошено, уведомления по интерфейсу не учитываются
+            wait.finished.assign(wait.interfaces.size(), 1);
+            wait.pending = 1; // Не даёт счётчику дойти до нуля, пока запускаются сканирования
+            wait.event = CreateEvent(NULL, TRUE, FALSE, NULL);
+            if (wait.event != NULL
+                && WlanRegisterNotification(hClient, WLAN_NOTIFICATION_SOURCE_ACM, TRUE, scan_notification_callback, &wait, NULL, NULL) != ERROR_SUCCESS) {
+                CloseHandle(wait.event);
+                wait.event = NULL;
+            }
+        }
+
+        // Выполняем сканирование перед получением списка сетей. Интерфейс
+        // учитывается в pending до WlanScan, так что быстрое уведомление не обгонит счётчик
+        for (int i = 0; i < (int)pIfList->dwNumberOfItems; i++) {
+            if (wait.event != NULL) {
+                InterlockedIncrement(&wait.pending);
+                InterlockedExchange(&wait.finished[i], 0);
+            }
+            if (WlanScan(hClient, &pIfList->InterfaceInfo[i].InterfaceGuid, NULL, NULL, NULL) != ERROR_SUCCESS) {
+                std::wcerr << L"Failed to scan networks for interface " << i << std::endl;
+                if (wait.event != NULL) {
+                    finish_scan(&wait, i);
+                }
+            }
+        }
+
+        if (wait.event != NULL) {
+            if (InterlockedDecrement(&wait.pending) > 0) {
+                WaitForSingleObject(wait.event, scanTimeoutMs);
+            }
+            WlanRegisterNotification(hClient, WLAN_NOTIFICATION_SOURCE_NONE, TRUE, NULL, NULL, NULL, NULL);
+        }
+
+        for (int i = 0; i < (int)pIfList->dwNumberOfItems; i++) {
+            PWLAN_INTERFACE_INFO pIfInfo = &pIfList->InterfaceInfo[i];
+
+            PWLAN_BSS_LIST pBssList = NULL;
+            if (WlanGetNetworkBssList(hClient, &pIfInfo->InterfaceGuid, NULL, dot11_BSS_type_any, FALSE, NULL, &pBssList) == ERROR_SUCCESS) {
+                if (pBssList != NULL) {
+                    for (unsigned int j = 0; j < pBssList->dwNumberOfItems; j++) {
+                        callback(pBssList->wlanBssEntries[j]);
+                    }
+                    WlanFreeMemory(pBssList);
+                }
+            } else {
+                std::wcerr << L"Failed to get BSS list for interface " << i << std::endl;
+            }
+        }
+        WlanFreeMemory(pIfList);
+    }
+
+    // WlanCloseHandle дожидается завершения уведомлений, после него событие можно закрыть
+    WlanCloseHandle(hClient, NULL);
+    if (wait.event != NULL) {
+        CloseHandle(wait.event);
+    }
+    return true;
+}
+
+#endif
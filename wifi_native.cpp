@@ -0,0 +1,511 @@
+// Модуль Python wifi_native: сканирование, модель расстояния и
+// позиционирование из wifi_core.h.
+//
+// Результаты возвращаются как объекты Column с поддержкой buffer protocol,
+// поэтому numpy.asarray(column) и memoryview(column) не копируют данные.
+// GIL освобождается на время сканирования и пакетных вычислений.
+//
+// Сборка: python setup.py build_ext --inplace
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ie_parser.h"
+#include "wifi_core.h"
+
+const unsigned long DEFAULT_SCAN_TIMEOUT_MS = 4000;
+
+// Одномерный массив фиксированного типа, владеющий своей памятью
+struct ColumnObject {
+    PyObject_HEAD
+    char* data;
+    Py_ssize_t length;
+    Py_ssize_t itemsize;
+    const char* format;
+};
+
+static void column_dealloc(ColumnObject* self) {
+    PyMem_Free(self->data);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+static int column_getbuffer(ColumnObject* self, Py_buffer* view, int flags) {
+    view->obj = reinterpret_cast<PyObject*>(self);
+    Py_INCREF(self);
+    view->buf = self->data;
+    view->len = self->length * self->itemsize;
+    view->readonly = 0;
+    view->itemsize = self->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(self->format) : nullptr;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &self->length : nullptr;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &self->itemsize : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    return 0;
+}
+
+static Py_ssize_t column_length(ColumnObject* self) {
+    return self->length;
+}
+
+static PyObject* column_repr(ColumnObject* self) {
+    return PyUnicode_FromFormat("<wifi_native.Column format='%s' length=%zd>", self->format, self->length);
+}
+
+static PyBufferProcs column_buffer_procs = {
+    reinterpret_cast<getbufferproc>(column_getbuffer),
+    nullptr,
+};
+
+static PySequenceMethods column_sequence_methods = {
+    reinterpret_cast<lenfunc>(column_length),
+};
+
+static PyTypeObject ColumnType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "wifi_native.Column",
+};
+
+template <typename T> struct ColumnFormat;
+template <> struct ColumnFormat<double> { static constexpr const char* value = "d"; };
+template <> struct ColumnFormat<int32_t> { static constexpr const char* value = "i"; };
+template <> struct ColumnFormat<uint64_t> { static constexpr const char* value = "Q"; };
+
+template <typename T>
+static ColumnObject* new_column(Py_ssize_t length) {
+    ColumnObject* column = PyObject_New(ColumnObject, &ColumnType);
+    if (column == nullptr) {
+        return nullptr;
+    }
+    column->data = nullptr;
+    column->length = length;
+    column->itemsize = sizeof(T);
+    column->format = ColumnFormat<T>::value;
+    column->data = static_cast<char*>(PyMem_Malloc(length > 0 ? length * sizeof(T) : 1));
+    if (column->data == nullptr) {
+        Py_DECREF(column);
+        return reinterpret_cast<ColumnObject*>(PyErr_NoMemory());
+    }
+    return column;
+}
+
+template <typename T>
+static T* column_data(ColumnObject* column) {
+    return reinterpret_cast<T*>(column->data);
+}
+
+// Числовой буфер любого поддерживаемого типа, прочитанный через buffer protocol
+class NumericView {
+public:
+    ~NumericView() {
+        if (acquired_) {
+            PyBuffer_Release(&view_);
+        }
+    }
+
+    bool acquire(PyObject* object, const char* name) {
+        if (PyObject_GetBuffer(object, &view_, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+            return false;
+        }
+        acquired_ = true;
+
+        const char* format = view_.format != nullptr ? view_.format : "B";
+        if (*format == '@' || *format == '=' || *format == '<') {
+            ++format;
+        }
+        if (std::strlen(format) != 1 || std::strchr("bBhHiIlLqQfd", *format) == nullptr) {
+            PyErr_Format(PyExc_TypeError, "%s: unsupported buffer format '%s'", name, view_.format);
+            return false;
+        }
+        code_ = *format;
+        length_ = view_.itemsize > 0 ? view_.len / view_.itemsize : 0;
+        return true;
+    }
+
+    Py_ssize_t length() const { return length_; }
+
+    double as_double(Py_ssize_t i) const {
+        const char* p = static_cast<const char*>(view_.buf) + i * view_.itemsize;
+        switch (code_) {
+            case 'b': return *reinterpret_cast<const signed char*>(p);
+            case 'B': return *reinterpret_cast<const unsigned char*>(p);
+            case 'h': return *reinterpret_cast<const short*>(p);
+            case 'H': return *reinterpret_cast<const unsigned short*>(p);
+            case 'i': return *reinterpret_cast<const int*>(p);
+            case 'I': return *reinterpret_cast<const unsigned int*>(p);
+            case 'l': return static_cast<double>(*reinterpret_cast<const long*>(p));
+            case 'L': return static_cast<double>(*reinterpret_cast<const unsigned long*>(p));
+            case 'q': return static_cast<double>(*reinterpret_cast<const long long*>(p));
+            case 'Q': return static_cast<double>(*reinterpret_cast<const unsigned long long*>(p));
+            case 'f': return *reinterpret_cast<const float*>(p);
+            default: return *reinterpret_cast<const double*>(p);
+        }
+    }
+
+    uint64_t as_key(Py_ssize_t i) const {
+        const char* p = static_cast<const char*>(view_.buf) + i * view_.itemsize;
+        switch (code_) {
+            case 'b': return static_cast<uint64_t>(*reinterpret_cast<const signed char*>(p));
+            case 'B': return *reinterpret_cast<const unsigned char*>(p);
+            case 'h': return static_cast<uint64_t>(*reinterpret_cast<const short*>(p));
+            case 'H': return *reinterpret_cast<const unsigned short*>(p);
+            case 'i': return static_cast<uint64_t>(*reinterpret_cast<const int*>(p));
+            case 'I': return *reinterpret_cast<const unsigned int*>(p);
+            case 'l': return static_cast<uint64_t>(*reinterpret_cast<const long*>(p));
+            case 'L': return *reinterpret_cast<const unsigned long*>(p);
+            case 'q': return static_cast<uint64_t>(*reinterpret_cast<const long long*>(p));
+            case 'Q': return *reinterpret_cast<const unsigned long long*>(p);
+            case 'f': return static_cast<uint64_t>(*reinterpret_cast<const float*>(p));
+            default: return static_cast<uint64_t>(*reinterpret_cast<const double*>(p));
+        }
+    }
+
+private:
+    Py_buffer view_ = {};
+    bool acquired_ = false;
+    char code_ = 'd';
+    Py_ssize_t length_ = 0;
+};
+
+static PyObject* wifi_calculate_distance(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = { "rssi", "frequency", nullptr };
+    PyObject* rssi;
+    double frequency = 2.4;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|d:calculate_distance", const_cast<char**>(keywords), &rssi, &frequency)) {
+        return nullptr;
+    }
+
+    if (PyNumber_Check(rssi) && !PyObject_CheckBuffer(rssi)) {
+        double value = PyFloat_AsDouble(rssi);
+        if (value == -1.0 && PyErr_Occurred()) {
+            return nullptr;
+        }
+        return PyFloat_FromDouble(calculate_distance(value, frequency));
+    }
+
+    NumericView view;
+    if (!view.acquire(rssi, "rssi")) {
+        return nullptr;
+    }
+    ColumnObject* result = new_column<double>(view.length());
+    if (result == nullptr) {
+        return nullptr;
+    }
+    double* out = column_data<double>(result);
+    Py_BEGIN_ALLOW_THREADS
+    for (Py_ssize_t i = 0; i < view.length(); ++i) {
+        out[i] = calculate_distance(view.as_double(i), frequency);
+    }
+    Py_END_ALLOW_THREADS
+    return reinterpret_cast<PyObject*>(result);
+}
+
+struct ScanRecord {
+    std::string Ssid; // Raw SSID bytes
+    uint64_t Bssid;
+    int32_t Rssi;
+    int32_t Frequency;
+    BssCapabilities Capabilities;
+};
+
+static PyObject* wifi_scan(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = { "timeout_ms", nullptr };
+    unsigned long timeoutMs = DEFAULT_SCAN_TIMEOUT_MS;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|k:scan", const_cast<char**>(keywords), &timeoutMs)) {
+        return nullptr;
+    }
+
+#ifndef _WIN32
+    PyErr_SetString(PyExc_OSError, "scanning requires the Windows WLAN API");
+    return nullptr;
+#else
+    // Кэш общий для всех вызовов; GIL на время сканирования отпущен, поэтому нужен свой мьютекс
+    static BssCapabilityCache capabilityCache;
+    static std::mutex capabilityMutex;
+    std::vector<ScanRecord> records;
+    bool ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = for_each_bss_entry([&records](const WLAN_BSS_ENTRY& entry) {
+        ScanRecord record;
+        record.Ssid.assign(reinterpret_cast<const char*>(entry.dot11Ssid.ucSSID), entry.dot11Ssid.uSSIDLength);
+        record.Bssid = 0;
+        for (int k = 0; k < 6; k++) {
+            record.Bssid = (record.Bssid << 8) | entry.dot11Bssid[k];
+        }
+        record.Rssi = entry.lRssi;
+        record.Frequency = entry.ulChCenterFrequency / 1000;
+        {
+            std::lock_guard<std::mutex> lock(capabilityMutex);
+            record.Capabilities = lookup_bss_capabilities(capabilityCache, record.Bssid, entry);
+        }
+        records.push_back(record);
+    }, timeoutMs);
+    Py_END_ALLOW_THREADS
+    if (!ok) {
+        PyErr_SetString(PyExc_OSError, "WLAN scan failed");
+        return nullptr;
+    }
+
+    Py_ssize_t count = static_cast<Py_ssize_t>(records.size());
+    PyObject* ssids = PyList_New(count);
+    PyObject* security = PyList_New(count);
+    PyObject* phy = PyList_New(count);
+    ColumnObject* bssids = new_column<uint64_t>(count);
+    ColumnObject* rssi = new_column<int32_t>(count);
+    ColumnObject* frequency = new_column<int32_t>(count);
+    ColumnObject* width = new_column<int32_t>(count);
+    ColumnObject* stations = new_column<int32_t>(count);
+    ColumnObject* utilization = new_column<int32_t>(count);
+    PyObject* result = PyDict_New();
+    PyObject* columns[] = {
+        ssids, security, phy,
+        reinterpret_cast<PyObject*>(bssids), reinterpret_cast<PyObject*>(rssi), reinterpret_cast<PyObject*>(frequency),
+        reinterpret_cast<PyObject*>(width), reinterpret_cast<PyObject*>(stations), reinterpret_cast<PyObject*>(utilization),
+    };
+    static const char* names[] = { "ssid", "security", "phy", "bssid", "rssi", "frequency", "width", "stations", "utilization" };
+    auto release = [&columns, &result]() {
+        for (PyObject* column : columns) {
+            Py_XDECREF(column);
+        }
+        Py_XDECREF(result);
+    };
+    bool failed = result == nullptr;
+    for (PyObject* column : columns) {
+        failed = failed || column == nullptr;
+    }
+    if (failed) {
+        release();
+        return nullptr;
+    }
+
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        const ScanRecord& record = records[i];
+        const BssCapabilities& caps = record.Capabilities;
+        PyObject* ssid = PyUnicode_DecodeUTF8(record.Ssid.data(), static_cast<Py_ssize_t>(record.Ssid.size()), "replace");
+        PyObject* securityName = PyUnicode_FromString(describe_security(caps).c_str());
+        PyObject* phyName = PyUnicode_FromString(describe_phy(caps));
+        if (ssid == nullptr || securityName == nullptr || phyName == nullptr) {
+            Py_XDECREF(ssid);
+            Py_XDECREF(securityName);
+            Py_XDECREF(phyName);
+            release();
+            return nullptr;
+        }
+        PyList_SET_ITEM(ssids, i, ssid);
+        PyList_SET_ITEM(security, i, securityName);
+        PyList_SET_ITEM(phy, i, phyName);
+        column_data<uint64_t>(bssids)[i] = record.Bssid;
+        column_data<int32_t>(rssi)[i] = record.Rssi;
+        column_data<int32_t>(frequency)[i] = record.Frequency;
+        column_data<int32_t>(width)[i] = caps.ChannelWidth;
+        column_data<int32_t>(stations)[i] = caps.HasBssLoad ? caps.StationCount : -1;
+        column_data<int32_t>(utilization)[i] = caps.HasBssLoad ? caps.ChannelUtilization * 100 / 255 : -1;
+    }
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        if (PyDict_SetItemString(result, names[i], columns[i]) < 0) {
+            release();
+            return nullptr;
+        }
+    }
+    for (PyObject* column : columns) {
+        Py_DECREF(column);
+    }
+    return result;
+#endif
+}
+
+// Radar: позиции точек с сохранённым случайным углом и сглаживанием, как в wifi-checker
+struct RadarObject {
+    PyObject_HEAD
+    std::map<uint64_t, std::pair<double, double>>* savedCoordinates;
+    std::map<uint64_t, std::pair<double, double>>* previousCoordinates;
+    std::mt19937* gen;
+    double alpha;
+    // Карты и генератор меняются без GIL, поэтому доступ к ним только под этим мьютексом.
+    // Захватывать его можно только с отпущенным GIL, иначе возможна взаимная блокировка
+    std::mutex* lock;
+};
+
+// Захватывает мьютекс Radar, не удерживая GIL во время ожидания
+static std::unique_lock<std::mutex> lock_radar(RadarObject* self) {
+    std::unique_lock<std::mutex> guard(*self->lock, std::defer_lock);
+    Py_BEGIN_ALLOW_THREADS
+    guard.lock();
+    Py_END_ALLOW_THREADS
+    return guard;
+}
+
+static PyObject* radar_new(PyTypeObject* type, PyObject* args, PyObject* kwargs) {
+    RadarObject* self = reinterpret_cast<RadarObject*>(PyType_GenericNew(type, args, kwargs));
+    if (self != nullptr) {
+        self->lock = new std::mutex();
+    }
+    return reinterpret_cast<PyObject*>(self);
+}
+
+static int radar_init(RadarObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = { "alpha", "seed", nullptr };
+    double alpha = 0.2;
+    PyObject* seed = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|dO:Radar", const_cast<char**>(keywords), &alpha, &seed)) {
+        return -1;
+    }
+
+    unsigned long seedValue;
+    if (seed == Py_None) {
+        seedValue = std::random_device()();
+    } else {
+        seedValue = PyLong_AsUnsignedLongMask(seed);
+        if (PyErr_Occurred()) {
+            return -1;
+        }
+    }
+
+    std::unique_lock<std::mutex> guard = lock_radar(self);
+    delete self->savedCoordinates;
+    delete self->previousCoordinates;
+    delete self->gen;
+    self->savedCoordinates = new std::map<uint64_t, std::pair<double, double>>();
+    self->previousCoordinates = new std::map<uint64_t, std::pair<double, double>>();
+    self->gen = new std::mt19937(static_cast<std::mt19937::result_type>(seedValue));
+    self->alpha = alpha;
+    return 0;
+}
+
+static void radar_dealloc(RadarObject* self) {
+    delete self->savedCoordinates;
+    delete self->previousCoordinates;
+    delete self->gen;
+    delete self->lock;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+static PyObject* radar_update(RadarObject* self, PyObject* args) {
+    PyObject* bssidObject;
+    PyObject* distanceObject;
+    if (!PyArg_ParseTuple(args, "OO:update", &bssidObject, &distanceObject)) {
+        return nullptr;
+    }
+    NumericView bssids, distances;
+    if (!bssids.acquire(bssidObject, "bssid") || !distances.acquire(distanceObject, "distance")) {
+        return nullptr;
+    }
+    if (bssids.length() != distances.length()) {
+        PyErr_SetString(PyExc_ValueError, "bssid and distance must have the same length");
+        return nullptr;
+    }
+
+    ColumnObject* x = new_column<double>(bssids.length());
+    ColumnObject* y = x != nullptr ? new_column<double>(bssids.length()) : nullptr;
+    if (y == nullptr) {
+        Py_XDECREF(x);
+        return nullptr;
+    }
+
+    double* outX = column_data<double>(x);
+    double* outY = column_data<double>(y);
+    bool initialized;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> guard(*self->lock);
+        initialized = self->gen != nullptr;
+        for (Py_ssize_t i = 0; initialized && i < bssids.length(); ++i) {
+            uint64_t key = bssids.as_key(i);
+            std::pair<double, double> point = place_point(key, distances.as_double(i), *self->savedCoordinates, *self->gen);
+            point = smooth_point(key, point, *self->previousCoordinates, self->alpha);
+            outX[i] = point.first;
+            outY[i] = point.second;
+        }
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!initialized) {
+        Py_DECREF(x);
+        Py_DECREF(y);
+        PyErr_SetString(PyExc_RuntimeError, "Radar is not initialized");
+        return nullptr;
+    }
+    return Py_BuildValue("(NN)", x, y);
+}
+
+static PyObject* radar_known(RadarObject* self, PyObject*) {
+    std::unique_lock<std::mutex> guard = lock_radar(self);
+    return PyLong_FromSize_t(self->savedCoordinates != nullptr ? self->savedCoordinates->size() : 0);
+}
+
+static PyMethodDef radar_methods[] = {
+    { "update", reinterpret_cast<PyCFunction>(radar_update), METH_VARARGS,
+      "update(bssid, distance) -> (x, y)\n\nPlaces a batch of access points and returns smoothed coordinates." },
+    { "known", reinterpret_cast<PyCFunction>(radar_known), METH_NOARGS,
+      "known() -> int\n\nNumber of access points with a remembered position." },
+    { nullptr, nullptr, 0, nullptr },
+};
+
+static PyTypeObject RadarType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "wifi_native.Radar",
+};
+
+static PyMethodDef module_methods[] = {
+    { "scan", reinterpret_cast<PyCFunction>(wifi_scan), METH_VARARGS | METH_KEYWORDS,
+      "scan(timeout_ms=4000) -> dict\n\nScans all WLAN interfaces and waits for the scan to complete.\n"
+      "Returns {'ssid': list[str], 'bssid': Column[uint64], 'rssi': Column[int32], 'frequency': Column[int32] (MHz),\n"
+      " 'security': list[str], 'phy': list[str], 'width': Column[int32] (MHz),\n"
+      " 'stations': Column[int32], 'utilization': Column[int32] (percent)}; stations and utilization are -1 without BSS Load." },
+    { "calculate_distance", reinterpret_cast<PyCFunction>(wifi_calculate_distance), METH_VARARGS | METH_KEYWORDS,
+      "calculate_distance(rssi, frequency=2.4)\n\nDistance in meters for a number or a buffer of RSSI values." },
+    { nullptr, nullptr, 0, nullptr },
+};
+
+static PyModuleDef wifi_native_module = {
+    PyModuleDef_HEAD_INIT,
+    "wifi_native",
+    "Native Wi-Fi scan, distance model and radar positioning.",
+    -1,
+    module_methods,
+};
+
+PyMODINIT_FUNC PyInit_wifi_native(void) {
+    ColumnType.tp_basicsize = sizeof(ColumnObject);
+    ColumnType.tp_dealloc = reinterpret_cast<destructor>(column_dealloc);
+    ColumnType.tp_repr = reinterpret_cast<reprfunc>(column_repr);
+    ColumnType.tp_as_sequence = &column_sequence_methods;
+    ColumnType.tp_as_buffer = &column_buffer_procs;
+    ColumnType.tp_flags = Py_TPFLAGS_DEFAULT;
+    ColumnType.tp_doc = "One-dimensional typed array exposed through the buffer protocol.";
+
+    RadarType.tp_basicsize = sizeof(RadarObject);
+    RadarType.tp_dealloc = reinterpret_cast<destructor>(radar_dealloc);
+    RadarType.tp_flags = Py_TPFLAGS_DEFAULT;
+    RadarType.tp_doc = "Radar(alpha=0.2, seed=None)\n\nRemembers access point positions between updates.";
+    RadarType.tp_methods = radar_methods;
+    RadarType.tp_init = reinterpret_cast<initproc>(radar_init);
+    RadarType.tp_new = radar_new;
+
+    if (PyType_Ready(&ColumnType) < 0 || PyType_Ready(&RadarType) < 0) {
+        return nullptr;
+    }
+
+    PyObject* module = PyModule_Create(&wifi_native_module);
+    if (module == nullptr) {
+        return nullptr;
+    }
+
+    Py_INCREF(&ColumnType);
+    Py_INCREF(&RadarType);
+    if (PyModule_AddObject(module, "Column", reinterpret_cast<PyObject*>(&ColumnType)) < 0
+        || PyModule_AddObject(module, "Radar", reinterpret_cast<PyObject*>(&RadarType)) < 0) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}